@@ -0,0 +1,600 @@
+//
+//  bench.cpp
+//  atomicx
+//
+//  Host benchmarks, build and run them with `make bench`.
+//
+//  Every result is printed as one JSON object per line, ex
+//  {"bench":"yield","mode":"copy","depth":1024,"ns":85.3}
+//
+//  mode is the kernel build (copy, dedicated, heap, table, simd or prio), std_thread
+//  marks the std::thread + std::condition_variable baseline, only
+//  built with -DBENCH_BASELINE.
+//
+
+#include "atomicx.hpp"
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#ifdef BENCH_BASELINE
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+#define BENCH_MODE "heap"
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE && defined(ATOMICX_SCHED_SIMD)
+#define BENCH_MODE "simd"
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+#define BENCH_MODE "table"
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+#define BENCH_MODE "prio"
+#elif defined(ATOMICX_DEDICATED_STACK)
+#define BENCH_MODE "dedicated"
+#else
+#define BENCH_MODE "copy"
+#endif
+
+/*
+ * Virtual time base: every GetTick moves the clock forward, so threads
+ * yielding with the same nice always alternate and SleepTick never sleeps.
+ * Wall time is measured apart with std::chrono.
+ */
+
+static atomicx_time g_tick = 0;
+
+atomicx_time atomicx::Thread::GetTick(void)
+{
+    return ++g_tick;
+}
+
+void atomicx::Thread::SleepTick(atomicx_time nSleep)
+{
+    g_tick += nSleep;
+}
+
+/*
+ * Join never returns while threads exist, a benchmark ends by jumping
+ * back to RunKernel from inside the measuring thread.
+ */
+
+static jmp_buf g_benchExit;
+
+static void RunKernel()
+{
+    if (setjmp(g_benchExit) == 0)
+    {
+        atomicx::Thread::Join();
+    }
+}
+
+static void FinishBenchmark()
+{
+    longjmp(g_benchExit, 1);
+}
+
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* *************************************************** *\
+    YIELD LATENCY x STACK DEPTH
+\* *************************************************** */
+
+class YieldThread : public atomicx::Thread
+{
+private:
+    volatile size_t nStack[8192];
+
+    size_t m_nFrames;
+    size_t m_nYields;
+    bool m_bLeader;
+
+    __attribute__((noinline)) void Nest(size_t nFrames)
+    {
+        volatile uint8_t pad[64];
+
+        pad[0] = (uint8_t)nFrames;
+
+        if (nFrames > 0)
+        {
+            Nest(nFrames - 1);
+        }
+        else
+        {
+            Measure();
+        }
+
+        pad[1] = pad[0];
+    }
+
+    void Measure()
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t nCount = 0; nCount < m_nYields; nCount++)
+        {
+            Yield(0);
+        }
+
+        if (m_bLeader)
+        {
+            // Every leader Yield is matched by one from the follower
+            printf("{\"bench\":\"yield\",\"mode\":\"%s\",\"depth\":%zu,\"ns\":%.1f}\n", BENCH_MODE, GetStackSize(),
+                   Elapsed(start) / (double)(m_nYields * 2));
+        }
+    }
+
+public:
+    YieldThread(size_t nFrames, size_t nYields, bool bLeader)
+        : Thread(0, nStack)
+        , m_nFrames(nFrames)
+        , m_nYields(nYields)
+        , m_bLeader(bLeader)
+    {
+    }
+
+    virtual void run() final
+    {
+        Nest(m_nFrames);
+
+        FinishBenchmark();
+    }
+
+    virtual const char *GetName() final
+    {
+        return "YieldThread";
+    }
+};
+
+static void BenchYield()
+{
+    static const size_t frames[] = { 0, 4, 16, 64, 256 };
+
+    for (size_t nFrames : frames)
+    {
+        // The follower never gets to finish, the leader ends the run first
+        YieldThread *pFollower = new YieldThread(nFrames, (size_t)-1, false);
+        YieldThread *pLeader   = new YieldThread(nFrames, 100000, true);
+
+        RunKernel();
+
+        delete pLeader;
+        delete pFollower;
+    }
+}
+
+/* *************************************************** *\
+    YIELD BACK TO THE SAME THREAD
+\* *************************************************** */
+
+class PollingThread : public atomicx::Thread
+{
+private:
+    volatile size_t nStack[8192];
+
+    size_t m_nYields;
+
+public:
+    PollingThread(size_t nYields)
+        : Thread(0, nStack)
+        , m_nYields(nYields)
+    {
+    }
+
+    virtual void run() final
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t nCount = 0; nCount < m_nYields; nCount++)
+        {
+            Yield(0);
+        }
+
+        printf("{\"bench\":\"yield_self\",\"mode\":\"%s\",\"depth\":%zu,\"ns\":%.1f}\n", BENCH_MODE, GetStackSize(),
+               Elapsed(start) / (double)m_nYields);
+
+        FinishBenchmark();
+    }
+
+    virtual const char *GetName() final
+    {
+        return "PollingThread";
+    }
+};
+
+static void BenchYieldSelf()
+{
+    PollingThread *pThread = new PollingThread(1000000);
+
+    RunKernel();
+
+    delete pThread;
+}
+
+/* *************************************************** *\
+    STACKLESS TASK SWITCH
+\* *************************************************** */
+
+class SwitchTask : public atomicx::Task
+{
+private:
+    size_t m_nSteps;
+    size_t m_nCount = 0;
+    bool m_bLeader;
+
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    SwitchTask(size_t nSteps, bool bLeader)
+        : Task(0)
+        , m_nSteps(nSteps)
+        , m_bLeader(bLeader)
+    {
+    }
+
+    virtual void Step() final
+    {
+        if (m_nCount == 0)
+        {
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        if (++m_nCount == m_nSteps && m_bLeader)
+        {
+            // Every leader step is matched by one from the follower
+            printf("{\"bench\":\"task_switch\",\"mode\":\"%s\",\"depth\":0,\"ns\":%.1f}\n", BENCH_MODE,
+                   Elapsed(m_start) / (double)(m_nSteps * 2));
+
+            FinishBenchmark();
+        }
+    }
+
+    virtual const char *GetName() final
+    {
+        return "SwitchTask";
+    }
+};
+
+static void BenchTask()
+{
+    SwitchTask *pFollower = new SwitchTask((size_t)-1, false);
+    SwitchTask *pLeader   = new SwitchTask(1000000, true);
+
+    RunKernel();
+
+    delete pLeader;
+    delete pFollower;
+}
+
+/* *************************************************** *\
+    NOTIFY / WAIT ROUND TRIP
+\* *************************************************** */
+
+static uint8_t g_ping;
+static uint8_t g_pong;
+
+class PingThread : public atomicx::Thread
+{
+private:
+    volatile size_t nStack[1024];
+
+    size_t m_nRounds;
+    bool m_bLeader;
+
+public:
+    PingThread(size_t nRounds, bool bLeader)
+        : Thread(0, nStack)
+        , m_nRounds(nRounds)
+        , m_bLeader(bLeader)
+    {
+    }
+
+    virtual void run() final
+    {
+        size_t nMessage = 0;
+
+        if (!m_bLeader)
+        {
+            while (true)
+            {
+                Wait(g_ping, 1, nMessage, 0);
+                Notify(g_pong, {.message = nMessage, .type = 1}, 1 << 20);
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t nCount = 0; nCount < m_nRounds; nCount++)
+        {
+            Notify(g_ping, {.message = nCount, .type = 1}, 1 << 20);
+            Wait(g_pong, 1, nMessage, 0);
+        }
+
+        printf("{\"bench\":\"notify_rtt\",\"mode\":\"%s\",\"ns\":%.1f}\n", BENCH_MODE, Elapsed(start) / (double)m_nRounds);
+
+        FinishBenchmark();
+    }
+
+    virtual const char *GetName() final
+    {
+        return "PingThread";
+    }
+};
+
+static void BenchNotify()
+{
+    PingThread *pPong = new PingThread(0, false);
+    PingThread *pPing = new PingThread(100000, true);
+
+    RunKernel();
+
+    delete pPing;
+    delete pPong;
+}
+
+/* *************************************************** *\
+    SCHEDULER COST x THREAD COUNT
+\* *************************************************** */
+
+static size_t g_nIdleStarted = 0;
+
+class IdleThread : public atomicx::Thread
+{
+private:
+    // Only ever in Yield, the smallest stack the mode allows
+    volatile size_t nStack[64 + ATOMICX_MIN_STACK_SIZE / sizeof(size_t)];
+
+public:
+    IdleThread()
+        : Thread(0, nStack)
+    {
+    }
+
+    virtual void run() final
+    {
+        g_nIdleStarted++;
+
+        while (true)
+        {
+            Yield(1 << 30);
+        }
+    }
+
+    virtual const char *GetName() final
+    {
+        return "IdleThread";
+    }
+};
+
+class SchedulerThread : public atomicx::Thread
+{
+private:
+    volatile size_t nStack[1024];
+
+    size_t m_nIdle;
+    size_t m_nYields;
+
+public:
+    SchedulerThread(size_t nIdle, size_t nYields)
+        : Thread(0, nStack)
+        , m_nIdle(nIdle)
+        , m_nYields(nYields)
+    {
+    }
+
+    virtual void run() final
+    {
+        // Let every idle thread park itself far in the future first
+        while (g_nIdleStarted < m_nIdle)
+        {
+            Yield(0);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t nCount = 0; nCount < m_nYields; nCount++)
+        {
+            Yield(0);
+        }
+
+        printf("{\"bench\":\"scheduler\",\"mode\":\"%s\",\"threads\":%zu,\"ns\":%.1f}\n", BENCH_MODE, m_nIdle + 1,
+               Elapsed(start) / (double)m_nYields);
+
+        FinishBenchmark();
+    }
+
+    virtual const char *GetName() final
+    {
+        return "SchedulerThread";
+    }
+};
+
+static void BenchScheduler()
+{
+    static const size_t threads[] = { 1, 10, 100, 1000, 10000 };
+
+    for (size_t nThreads : threads)
+    {
+        IdleThread **pIdle = new IdleThread *[nThreads - 1];
+
+        for (size_t nCount = 0; nCount < nThreads - 1; nCount++)
+        {
+            pIdle[nCount] = new IdleThread();
+        }
+
+        g_nIdleStarted = 0;
+
+        SchedulerThread *pThread = new SchedulerThread(nThreads - 1, nThreads > 1000 ? 2000 : 100000);
+
+        RunKernel();
+
+        delete pThread;
+
+        for (size_t nCount = 0; nCount < nThreads - 1; nCount++)
+        {
+            delete pIdle[nCount];
+        }
+
+        delete[] pIdle;
+    }
+}
+
+/* *************************************************** *\
+    MUTEX HAND-OFF
+\* *************************************************** */
+
+static atomicx::Mutex *g_pMutex = nullptr;
+
+class LockThread : public atomicx::Thread
+{
+private:
+    volatile size_t nStack[1024];
+
+    size_t m_nLocks;
+    bool m_bLeader;
+
+public:
+    LockThread(size_t nLocks, bool bLeader)
+        : Thread(0, nStack)
+        , m_nLocks(nLocks)
+        , m_bLeader(bLeader)
+    {
+    }
+
+    virtual void run() final
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        // Holding the lock across Yield forces a hand-off on every Unlock
+        for (size_t nCount = 0; nCount < m_nLocks; nCount++)
+        {
+            g_pMutex->Lock();
+            Yield(0);
+            g_pMutex->Unlock();
+        }
+
+        if (m_bLeader)
+        {
+            printf("{\"bench\":\"mutex_handoff\",\"mode\":\"%s\",\"threads\":2,\"ns\":%.1f}\n", BENCH_MODE,
+                   Elapsed(start) / (double)(m_nLocks * 2));
+        }
+
+        FinishBenchmark();
+    }
+
+    virtual const char *GetName() final
+    {
+        return "LockThread";
+    }
+};
+
+static void BenchMutex()
+{
+    g_pMutex = new atomicx::Mutex();
+
+    LockThread *pFollower = new LockThread((size_t)-1, false);
+    LockThread *pLeader   = new LockThread(100000, true);
+
+    RunKernel();
+
+    delete pLeader;
+    delete pFollower;
+
+    // The follower was left holding or waiting for the lock
+    delete g_pMutex;
+}
+
+#ifdef BENCH_BASELINE
+
+/* *************************************************** *\
+    STD::THREAD + CONDITION VARIABLE BASELINE
+\* *************************************************** */
+
+static void BenchBaseline()
+{
+    const size_t nRounds = 100000;
+
+    std::mutex lock;
+    std::condition_variable ping;
+    std::condition_variable pong;
+    size_t nTurn = 0;
+
+    std::thread ponger([&]() {
+        std::unique_lock<std::mutex> guard(lock);
+
+        for (size_t nCount = 0; nCount < nRounds; nCount++)
+        {
+            ping.wait(guard, [&]() { return nTurn % 2 == 1; });
+            nTurn++;
+            pong.notify_one();
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        std::unique_lock<std::mutex> guard(lock);
+
+        for (size_t nCount = 0; nCount < nRounds; nCount++)
+        {
+            nTurn++;
+            ping.notify_one();
+            pong.wait(guard, [&]() { return nTurn % 2 == 0; });
+        }
+    }
+
+    printf("{\"bench\":\"notify_rtt\",\"mode\":\"std_thread\",\"ns\":%.1f}\n", Elapsed(start) / (double)nRounds);
+
+    ponger.join();
+
+    std::mutex handoff;
+    std::condition_variable released;
+    size_t nOwner = 0;
+
+    // Every release goes to the other thread, as Mutex hands over to its waiter
+    auto alternate = [&](size_t nSelf) {
+        std::unique_lock<std::mutex> guard(handoff);
+
+        for (size_t nCount = 0; nCount < nRounds; nCount++)
+        {
+            released.wait(guard, [&]() { return nOwner == nSelf; });
+            nOwner = 1 - nSelf;
+            released.notify_one();
+        }
+    };
+
+    start = std::chrono::steady_clock::now();
+
+    std::thread other(alternate, 1);
+    alternate(0);
+    other.join();
+
+    printf("{\"bench\":\"mutex_handoff\",\"mode\":\"std_thread\",\"threads\":2,\"ns\":%.1f}\n",
+           Elapsed(start) / (double)(nRounds * 2));
+}
+
+#endif
+
+int main()
+{
+    BenchYield();
+    BenchYieldSelf();
+    BenchTask();
+    BenchNotify();
+    BenchScheduler();
+    BenchMutex();
+
+#ifdef BENCH_BASELINE
+    BenchBaseline();
+#endif
+
+    return 0;
+}
@@ -6,8 +6,40 @@
 #include <string.h>
 #include <unistd.h>
 
+#ifdef ATOMICX_DEDICATED_STACK
+#include <ucontext.h>
+#endif
+
+#if defined(ATOMICX_REACTOR) || defined(ATOMICX_OUTSIDE_NOTIFY)
+#include <errno.h>
+#include <limits.h>
+#endif
+
+#ifdef ATOMICX_REACTOR
+#include <sys/epoll.h>
+#endif
+
+#if defined(ATOMICX_OUTSIDE_NOTIFY) && defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#endif
+
 #include "atomicx.hpp"
 
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+static_assert(ATOMICX_PRIO_LEVELS >= 1 && ATOMICX_PRIO_LEVELS <= 256, "ATOMICX_PRIO_LEVELS must be within 1 and 256");
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE && defined(ATOMICX_SCHED_SIMD)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static_assert(sizeof(atomicx_time) == sizeof(int32_t), "ATOMICX_SCHED_SIMD needs a 32-bit atomicx_time");
+#endif
+
 #define caseStatus(st) \
 	case st:           \
 		name = #st;    \
@@ -35,6 +67,7 @@ namespace atomicx
 			caseStatus(Status::timeout);
 			caseStatus(Status::halted);
 			caseStatus(Status::paused);
+			caseStatus(Status::periodic);
 
 			caseStatus(Status::locked);
 
@@ -65,26 +98,33 @@ namespace atomicx
     }
 
 	Timeout::Timeout(atomicx_time nTimeoutValue)
-	    : m_timeoutValue(nTimeoutValue ? nTimeoutValue + Thread::GetTick() : 0)
 	{
+		Set(nTimeoutValue);
 	}
 
 	void Timeout::Set(atomicx_time nTimeoutValue)
 	{
 		m_timeoutValue = nTimeoutValue ? nTimeoutValue + Thread::GetTick() : 0;
+
+		// 0 means no timeout, a deadline wrapping exactly onto it expires one tick early
+		if (nTimeoutValue && m_timeoutValue == 0)
+		{
+			m_timeoutValue--;
+		}
+
 		TRACE(DEBUG, "nTimeoutValue: " << nTimeoutValue << ", m_timeoutValue: " << m_timeoutValue);
 	}
 
 	bool Timeout::IsTimedout()
 	{
-		return (m_timeoutValue == 0 || m_timeoutValue > Thread::GetTick()) ? false : true;
+		return (m_timeoutValue == 0 || IsTimeBefore(Thread::GetTick(), m_timeoutValue)) ? false : true;
 	}
 
 	atomicx_time Timeout::GetRemaining()
 	{
 		auto nNow = Thread::GetTick();
 
-		return (m_timeoutValue && nNow < m_timeoutValue) ? m_timeoutValue - Thread::GetTick() : 0;
+		return (m_timeoutValue && IsTimeBefore(nNow, m_timeoutValue)) ? m_timeoutValue - nNow : 0;
 	}
 
 	atomicx_time Timeout::GetDurationSince(atomicx_time startTime)
@@ -92,21 +132,162 @@ namespace atomicx
 		return startTime - GetRemaining();
 	}
 
+	/*
+        WAIT LIST
+    */
+
+	void WaitList::Push(Thread &thread)
+	{
+		if (thread.m_pWaitList != nullptr)
+		{
+			thread.m_pWaitList->Remove(thread);
+		}
+
+		thread.m_pWaitList = this;
+		thread.m_pWaitPrev = m_pTail;
+		thread.m_pWaitNext = nullptr;
+
+		if (m_pTail == nullptr)
+		{
+			m_pHead = &thread;
+		}
+		else
+		{
+			m_pTail->m_pWaitNext = &thread;
+		}
+
+		m_pTail = &thread;
+	}
+
+	void WaitList::Remove(Thread &thread)
+	{
+		if (thread.m_pWaitList != this)
+		{
+			return;
+		}
+
+		if (thread.m_pWaitPrev == nullptr)
+		{
+			m_pHead = thread.m_pWaitNext;
+		}
+		else
+		{
+			thread.m_pWaitPrev->m_pWaitNext = thread.m_pWaitNext;
+		}
+
+		if (thread.m_pWaitNext == nullptr)
+		{
+			m_pTail = thread.m_pWaitPrev;
+		}
+		else
+		{
+			thread.m_pWaitNext->m_pWaitPrev = thread.m_pWaitPrev;
+		}
+
+		thread.m_pWaitList = nullptr;
+		thread.m_pWaitPrev = nullptr;
+		thread.m_pWaitNext = nullptr;
+	}
+
+	Thread *WaitList::GetFirst()
+	{
+		return m_pHead;
+	}
+
+	bool WaitList::IsEmpty()
+	{
+		return m_pHead == nullptr;
+	}
+
 	/*
         THREAD
     */
 
 	// Thread kernel static initializations
 
-	Thread *Thread::m_pBegin   = nullptr;
-	Thread *Thread::m_pEnd     = nullptr;
-	Thread *Thread::m_pCurrent = nullptr;
+	ATOMICX_KERNEL_LOCAL Thread *Thread::m_pBegin   = nullptr;
+	ATOMICX_KERNEL_LOCAL Thread *Thread::m_pEnd     = nullptr;
+	ATOMICX_KERNEL_LOCAL Thread *Thread::m_pCurrent = nullptr;
+
+	ATOMICX_KERNEL_LOCAL size_t Thread::m_nNodeCounter = 0;
+
+	ATOMICX_KERNEL_LOCAL volatile uint8_t *Thread::m_pStartStack = nullptr;
+
+	ATOMICX_KERNEL_LOCAL jmp_buf Thread::m_joinContext = {};
+
+	ATOMICX_KERNEL_LOCAL WaitList Thread::m_waitBuckets[ATOMICX_WAIT_BUCKETS] = {};
+
+	volatile size_t Thread::m_nNoStack = 0;
 
-	size_t Thread::m_nNodeCounter = 0;
+#ifdef ATOMICX_ACCOUNTING
+	ATOMICX_KERNEL_LOCAL atomicx_time Thread::m_nIdleTicks = 0;
+#endif
 
-	volatile uint8_t *Thread::m_pStartStack = nullptr;
+#ifdef ATOMICX_REACTOR
+	ATOMICX_KERNEL_LOCAL int Thread::m_nEpoll               = -1;
+	ATOMICX_KERNEL_LOCAL size_t Thread::m_nIoWaiters        = 0;
+	ATOMICX_KERNEL_LOCAL atomicx_time Thread::m_nLastPoll   = 0;
+	ATOMICX_KERNEL_LOCAL WaitList Thread::m_ioWaitList      = {};
+#endif
 
-	jmp_buf Thread::m_joinContext = {};
+#ifdef ATOMICX_OUTSIDE_NOTIFY
+	std::atomic<int> Thread::m_nWakeFd{-1};
+
+#ifndef ATOMICX_MULTICORE
+	MpscQueue<Thread::OutsideNotify, ATOMICX_OUTSIDE_QUEUE_SIZE> Thread::m_outsideQueue;
+#endif
+#endif
+
+#if defined(ATOMICX_REACTOR) || defined(ATOMICX_OUTSIDE_WAKE)
+	// Ticks to a poll timeout, rounded up: waking before nextEvent would only spin till it comes
+	static int TicksToMs(atomicx_time nSleep)
+	{
+		if (nSleep == (atomicx_time)-1)
+		{
+			return -1;
+		}
+
+		atomicx_time nMs = nSleep / ATOMICX_TICKS_PER_MS + (nSleep % ATOMICX_TICKS_PER_MS != 0);
+
+		return nMs > INT_MAX ? INT_MAX : (int)nMs;
+	}
+#endif
+
+#ifdef ATOMICX_EVENT_TRACE
+	ATOMICX_KERNEL_LOCAL Thread::TraceRecord Thread::m_traceRing[ATOMICX_EVENT_TRACE_SIZE] = {};
+	ATOMICX_KERNEL_LOCAL size_t Thread::m_nTraceCount                                      = 0;
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+	ATOMICX_KERNEL_LOCAL Thread *Thread::m_schedHeap[ATOMICX_SCHED_HEAP_SIZE] = {};
+	ATOMICX_KERNEL_LOCAL size_t Thread::m_nSchedHeapSize                      = 0;
+	ATOMICX_KERNEL_LOCAL size_t Thread::m_nSchedCounter                       = 0;
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+	ATOMICX_KERNEL_LOCAL Thread *Thread::m_schedThread[ATOMICX_MAX_THREADS]         = {};
+	ATOMICX_KERNEL_LOCAL atomicx_time Thread::m_schedNextEvent[ATOMICX_MAX_THREADS] = {};
+	ATOMICX_KERNEL_LOCAL int32_t Thread::m_schedRank[ATOMICX_MAX_THREADS]           = {};
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+	ATOMICX_KERNEL_LOCAL Thread *Thread::m_readyHead[ATOMICX_PRIO_LEVELS]     = {};
+	ATOMICX_KERNEL_LOCAL Thread *Thread::m_readyTail[ATOMICX_PRIO_LEVELS]     = {};
+	ATOMICX_KERNEL_LOCAL uint32_t Thread::m_readyBitmap[Thread::PRIO_WORDS]   = {};
+	ATOMICX_KERNEL_LOCAL uint32_t Thread::m_readySummary                      = 0;
+	ATOMICX_KERNEL_LOCAL Thread *Thread::m_delayHeap[ATOMICX_MAX_THREADS]     = {};
+	ATOMICX_KERNEL_LOCAL size_t Thread::m_nDelayHeapSize                      = 0;
+	ATOMICX_KERNEL_LOCAL atomicx_time Thread::m_nSchedTick                    = 0;
+#endif
+
+#ifdef ATOMICX_MULTICORE
+	ATOMICX_KERNEL_LOCAL Kernel Thread::m_kernel;
+
+	std::atomic<size_t> Thread::m_nTotalThreads{0};
+
+	std::atomic<Kernel *> Kernel::m_kernels[ATOMICX_MAX_KERNELS] = {};
+	std::atomic<size_t> Kernel::m_nKernels{0};
+#endif
 
 	/* ------------------------ */
 
@@ -125,6 +306,47 @@ namespace atomicx
 	// Thread methods
 	bool Thread::AttachThread(Thread &thread)
 	{
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+		if (m_nSchedHeapSize >= ATOMICX_SCHED_HEAP_SIZE)
+		{
+			return false;
+		}
+
+		thread.m_nSchedSeq                = m_nSchedCounter++;
+		thread.m_nSchedIndex              = m_nSchedHeapSize++;
+		m_schedHeap[thread.m_nSchedIndex] = &thread;
+		SchedHeapUp(thread.m_nSchedIndex);
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+		if (m_nNodeCounter >= ATOMICX_MAX_THREADS)
+		{
+			TRACE(ERROR, "Ready lists full, ATOMICX_MAX_THREADS is " << ATOMICX_MAX_THREADS);
+			return false;
+		}
+
+		// Before the first selection the tick may be half a wrap away from 0
+		m_nSchedTick = GetTick();
+
+		thread.m_schedState = SchedState::parked;
+		SchedRequeue(thread);
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+		if (m_nNodeCounter >= ATOMICX_MAX_THREADS)
+		{
+			TRACE(ERROR, "Thread table full, ATOMICX_MAX_THREADS is " << ATOMICX_MAX_THREADS);
+			return false;
+		}
+
+		thread.m_nSchedIndex = m_nNodeCounter++;
+
+		m_schedThread[thread.m_nSchedIndex] = &thread;
+		thread.UpdateSchedule();
+
+		m_pBegin = m_schedThread[0];
+		m_pEnd   = &thread;
+#else
 		if (m_pBegin == nullptr)
 		{
 			m_pBegin = &thread;
@@ -138,16 +360,74 @@ namespace atomicx
 		}
 
 		m_nNodeCounter++;
+#endif
+
+#ifdef ATOMICX_MULTICORE
+		// Visible from the first thread on, so the idle instances can already ask for work
+		m_kernel.Register();
+		m_kernel.m_nThreads.store(m_nNodeCounter, std::memory_order_relaxed);
+#endif
 
 		return true;
 	}
 
 	bool Thread::DetachThread(Thread &thread)
 	{
+		// Already detached, halted or migrated away
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+		if (thread.m_nSchedIndex >= m_nNodeCounter || m_schedThread[thread.m_nSchedIndex] != &thread)
+#else
+		if (thread.pPrev == nullptr && m_pBegin != &thread)
+#endif
+		{
+			return false;
+		}
+
+		if (thread.m_pWaitList != nullptr)
+		{
+			thread.m_pWaitList->Remove(thread);
+		}
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+		if (thread.m_nSchedIndex < m_nSchedHeapSize && m_schedHeap[thread.m_nSchedIndex] == &thread)
+		{
+			size_t nIndex = thread.m_nSchedIndex;
+
+			SchedHeapSwap(nIndex, --m_nSchedHeapSize);
+
+			if (nIndex < m_nSchedHeapSize)
+			{
+				m_schedHeap[nIndex]->UpdateSchedule();
+			}
+		}
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+		SchedUnlink(thread);
+
+		thread.m_schedState = SchedState::detached;
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+		m_nNodeCounter--;
+
+		// Shifting keeps the attach order, ties are broken as by the list
+		for (size_t nIndex = thread.m_nSchedIndex; nIndex < m_nNodeCounter; nIndex++)
+		{
+			m_schedThread[nIndex]    = m_schedThread[nIndex + 1];
+			m_schedNextEvent[nIndex] = m_schedNextEvent[nIndex + 1];
+			m_schedRank[nIndex]      = m_schedRank[nIndex + 1];
+
+			m_schedThread[nIndex]->m_nSchedIndex = nIndex;
+		}
+
+		m_schedThread[m_nNodeCounter] = nullptr;
+
+		m_pBegin = m_nNodeCounter > 0 ? m_schedThread[0] : nullptr;
+		m_pEnd   = m_nNodeCounter > 0 ? m_schedThread[m_nNodeCounter - 1] : nullptr;
+#else
 		if (thread.pNext == nullptr && thread.pPrev == nullptr)
 		{
-			m_pBegin     = nullptr;
-			thread.pPrev = nullptr;
+			m_pBegin = nullptr;
+			m_pEnd   = nullptr;
 		}
 		else if (thread.pPrev == nullptr)
 		{
@@ -165,192 +445,2678 @@ namespace atomicx
 			thread.pNext->pPrev = thread.pPrev;
 		}
 
+		// A migrated thread is attached again elsewhere, no stale links
+		thread.pPrev = nullptr;
+		thread.pNext = nullptr;
+
 		m_nNodeCounter--;
+#endif
+
+#ifdef ATOMICX_MULTICORE
+		m_kernel.m_nThreads.store(m_nNodeCounter, std::memory_order_relaxed);
+#endif
 
 		return true;
 	}
 
+	inline Thread *Thread::GetNextAttached(Thread &thread)
+	{
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+		size_t nIndex = thread.m_nSchedIndex + 1;
+
+		return (nIndex < m_nNodeCounter && m_schedThread[nIndex - 1] == &thread) ? m_schedThread[nIndex] : nullptr;
+#else
+		return thread.pNext;
+#endif
+	}
+
 	inline Thread *Thread::GetCyclicalNext()
 	{
-		return (m_pCurrent->pNext) == nullptr ? (m_pCurrent = m_pBegin) : m_pCurrent->pNext;
+		Thread *pNext = GetNextAttached(*m_pCurrent);
+
+		return pNext == nullptr ? (m_pCurrent = m_pBegin) : pNext;
 	}
 
-	void Thread::Scheduler()
+	inline bool Thread::IsScheduledBefore(Thread &thread, Thread &other)
 	{
-		size_t nThreadCount = m_nNodeCounter;
-		Thread *pThread     = m_pCurrent;
-		atomicx_time tm     = GetTick();
+		return IsTimeBefore(thread.m_nextEvent, other.m_nextEvent)
+		       || (thread.m_nextEvent == other.m_nextEvent && thread.m_priority > other.m_priority);
+	}
 
-		while (nThreadCount--)
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_EDF
+	inline bool Thread::IsDeadlineBefore(Thread &thread, Thread &other)
+	{
+		return IsTimeBefore(thread.m_nDeadline, other.m_nDeadline)
+		       || (thread.m_nDeadline == other.m_nDeadline && thread.m_priority > other.m_priority);
+	}
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+
+	/*
+     * Scheduler min-heap, the key is (noTimout, nextEvent, -priority, seq);
+     * threads waiting without timeout sink to the bottom instead of leaving
+     * the heap, and full ties go to the thread re-keyed first, so the top is
+     * always the one to pick.
+     */
+
+	inline bool Thread::IsHeapBefore(Thread &thread, Thread &other)
+	{
+		if (thread.m_flags.noTimout != other.m_flags.noTimout)
 		{
-			pThread = (pThread->pNext) == nullptr ? (pThread = m_pBegin) : pThread->pNext;
+			return other.m_flags.noTimout;
+		}
+
+		if (thread.m_nextEvent != other.m_nextEvent || thread.m_priority != other.m_priority)
+		{
+			return IsScheduledBefore(thread, other);
+		}
+
+		// Serial number compare, the counter may wrap
+		return (intptr_t)(thread.m_nSchedSeq - other.m_nSchedSeq) < 0;
+	}
+
+	inline void Thread::SchedHeapSwap(size_t nIndexA, size_t nIndexB)
+	{
+		Thread *pThread = m_schedHeap[nIndexA];
 
-			TRACE(KERNEL, pThread << "." << pThread->GetName() << ": Status: " << GetStatusName(pThread->m_status) << ", Now: " << tm
-			                      << ", nextEvent: " << (int32_t)(pThread->m_nextEvent - tm) << ":" << pThread->m_nextEvent);
+		m_schedHeap[nIndexA] = m_schedHeap[nIndexB];
+		m_schedHeap[nIndexB] = pThread;
 
-			if (!pThread->m_flags.noTimout && m_pCurrent->m_nextEvent >= pThread->m_nextEvent)
+		m_schedHeap[nIndexA]->m_nSchedIndex = nIndexA;
+		m_schedHeap[nIndexB]->m_nSchedIndex = nIndexB;
+	}
+
+	void Thread::SchedHeapUp(size_t nIndex)
+	{
+		while (nIndex > 0)
+		{
+			size_t nParent = (nIndex - 1) / 2;
+
+			if (!IsHeapBefore(*m_schedHeap[nIndex], *m_schedHeap[nParent]))
 			{
-				m_pCurrent = pThread->m_nextEvent == m_pCurrent->m_nextEvent ?
-				                 pThread->m_priority > m_pCurrent->m_priority ? pThread : m_pCurrent :
-				                 pThread;
+				break;
 			}
-		}
 
-		TRACE(KERNEL, m_pCurrent << "." << m_pCurrent->GetName() << ": LEAVING Status: " << GetStatusName(m_pCurrent->m_status)
-		                         << ", Now: " << tm << ", nextEvent: " << (int32_t)(m_pCurrent->m_nextEvent - tm));
+			SchedHeapSwap(nIndex, nParent);
+			nIndex = nParent;
+		}
+	}
 
-		tm = GetTick();
-		if (m_pCurrent->m_nextEvent > tm)
+	void Thread::SchedHeapDown(size_t nIndex)
+	{
+		while (true)
 		{
-			TRACE(KERNEL, "SLEEPING: " << pThread << "." << pThread->GetName() << ", Status;" << GetStatusName(m_pCurrent->m_status)
-			                           << ", tm: " << tm << ", next: " << m_pCurrent->m_nextEvent
-			                           << ", sleep: " << (int32_t)(m_pCurrent->m_nextEvent - tm));
+			size_t nChild = nIndex * 2 + 1;
+
+			if (nChild >= m_nSchedHeapSize)
+			{
+				break;
+			}
 
-			SleepTick(m_pCurrent->m_nextEvent - tm);
+			if (nChild + 1 < m_nSchedHeapSize && IsHeapBefore(*m_schedHeap[nChild + 1], *m_schedHeap[nChild]))
+			{
+				nChild++;
+			}
+
+			if (!IsHeapBefore(*m_schedHeap[nChild], *m_schedHeap[nIndex]))
+			{
+				break;
+			}
 
-			if (m_pCurrent->m_status >= Status::wait)
-			 	m_pCurrent->m_status = Status::timeout;
+			SchedHeapSwap(nIndex, nChild);
+			nIndex = nChild;
 		}
-        
-        m_pCurrent->m_flags.noTimout = false;
-		m_pCurrent->m_late = m_pCurrent->m_nextEvent - GetTick();
 	}
 
-	void Thread::SetPriority(uint8_t value)
+	Thread *Thread::SchedHeapNext()
 	{
-		m_priority = value;
+		if (m_nSchedHeapSize == 0 || m_schedHeap[0]->m_flags.noTimout)
+		{
+			return nullptr;
+		}
+
+		Thread &top = *m_schedHeap[0];
+
+		// The current thread wins any tie, as the list scan starts from it
+		if (!IsScheduledBefore(top, *m_pCurrent))
+		{
+			return m_pCurrent;
+		}
+
+		return &top;
 	}
 
-	bool Thread::Join()
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+
+	/*
+     * Strict priority, every attached thread is parked (waiting without
+     * timeout), delayed (nextEvent still ahead) or in the ready list of its
+     * level; SelectNext moves the delayed ones to their ready list once due.
+     */
+
+	void Thread::SchedRequeue(Thread &thread)
 	{
-		m_pCurrent = m_pEnd;
+		SchedUnlink(thread);
 
-		if (m_pCurrent != nullptr)
+		if (thread.m_flags.noTimout)
 		{
-			m_pStartStack = GetStackPoint(); //&nStackPoint;
+			return;
+		}
 
-			setjmp(m_joinContext);
+		if (!IsTimeBefore(m_nSchedTick, thread.m_nextEvent))
+		{
+			SchedReadyInsert(thread);
 
-			if (m_nNodeCounter == 0)
+			return;
+		}
+
+		thread.m_schedState               = SchedState::delayed;
+		thread.m_nSchedIndex              = m_nDelayHeapSize++;
+		m_delayHeap[thread.m_nSchedIndex] = &thread;
+
+		SchedDelayUp(thread.m_nSchedIndex);
+	}
+
+	void Thread::SchedUnlink(Thread &thread)
+	{
+		if (thread.m_schedState == SchedState::ready)
+		{
+			size_t nLevel = thread.m_nReadyLevel;
+
+			if (thread.m_pReadyPrev == nullptr)
 			{
-				return false;
+				m_readyHead[nLevel] = thread.m_pReadyNext;
+			}
+			else
+			{
+				thread.m_pReadyPrev->m_pReadyNext = thread.m_pReadyNext;
 			}
 
-			// m_pCurrent = GetCyclicalNext ();
-			Thread::Scheduler();
+			if (thread.m_pReadyNext == nullptr)
+			{
+				m_readyTail[nLevel] = thread.m_pReadyPrev;
+			}
+			else
+			{
+				thread.m_pReadyNext->m_pReadyPrev = thread.m_pReadyPrev;
+			}
 
-			TRACE(KERNEL, "------------------------------------");
-			TRACE(KERNEL, m_pCurrent->GetName()
-			                  << "_" << (size_t)m_pCurrent << ": St [" << GetStatusName(m_pCurrent->m_status) << "]");
-			TRACE(KERNEL, "Stack size: " << m_pCurrent->nStackSize << ", Max: " << m_pCurrent->m_nMaxStackSize
-			                             << ", Occupied: " << (100 * m_pCurrent->nStackSize) / (m_pCurrent->m_nMaxStackSize) << "%");
+			thread.m_pReadyPrev = nullptr;
+			thread.m_pReadyNext = nullptr;
 
-			if (m_pCurrent->m_status == Status::starting)
+			if (m_readyHead[nLevel] == nullptr)
 			{
-				m_pCurrent->m_status = Status::running;
+				m_readyBitmap[nLevel / 32] &= ~(1u << (nLevel % 32));
 
-				m_pCurrent->run();
+				if (m_readyBitmap[nLevel / 32] == 0)
+				{
+					m_readySummary &= ~(1u << (nLevel / 32));
+				}
+			}
+		}
+		else if (thread.m_schedState == SchedState::delayed)
+		{
+			size_t nIndex = thread.m_nSchedIndex;
 
-				m_pCurrent->m_status = Status::starting;
+			SchedDelaySwap(nIndex, --m_nDelayHeapSize);
 
-				longjmp(m_joinContext, 1);
-			}
-			else
+			if (nIndex < m_nDelayHeapSize)
 			{
-				longjmp(m_pCurrent->m_context, 1);
+				Thread *pMoved = m_delayHeap[nIndex];
+
+				SchedDelayUp(nIndex);
+				SchedDelayDown(pMoved->m_nSchedIndex);
 			}
 		}
 
-		TRACE(TRACE, "NO THREAD TO RUN.... #" << m_nNodeCounter);
-
-		return false;
+		thread.m_schedState = SchedState::parked;
 	}
 
-	bool Thread::Yield(atomicx_time tm, Status st)
+	void Thread::SchedReadyInsert(Thread &thread)
 	{
-		m_pCurrent->m_pEndStack = GetStackPoint();
-		m_pCurrent->nStackSize  = m_pStartStack - m_pCurrent->m_pEndStack + sizeof(size_t);
-
-		TRACE(KERNEL, "Stack size: " << m_pCurrent->nStackSize << ", Max: " << m_pCurrent->m_nMaxStackSize
-		                             << ", Occupied: " << (100 * m_pCurrent->nStackSize) / (m_pCurrent->m_nMaxStackSize) << "%");
+		size_t nLevel = thread.m_priority;
 
-		if (st == Status::now)
-		{
-			tm = GetTick();
-		}
-		else
+		if (nLevel >= ATOMICX_PRIO_LEVELS)
 		{
-			tm = GetTick() + (tm ? tm : m_pCurrent->m_nice);
+			nLevel = ATOMICX_PRIO_LEVELS - 1;
 		}
 
-		m_pCurrent->m_status    = st;
-		m_pCurrent->m_nextEvent = tm;
+		// From the tail, the thread is most often the last one to come due
+		Thread *pPrev = m_readyTail[nLevel];
 
-		if (setjmp(m_pCurrent->m_context) != 0)
+		while (pPrev != nullptr && IsTimeBefore(thread.m_nextEvent, pPrev->m_nextEvent))
 		{
-			m_pCurrent->nStackSize = m_pStartStack - m_pCurrent->m_pEndStack;
-			memcpy((void *)m_pCurrent->m_pEndStack, (const void *)&m_pCurrent->m_stack, m_pCurrent->nStackSize);
+			pPrev = pPrev->m_pReadyPrev;
+		}
 
-			NOTRACE(KERNEL, (size_t)m_pCurrent << ": RETURNED from Join.");
+		thread.m_pReadyPrev = pPrev;
+		thread.m_pReadyNext = pPrev == nullptr ? m_readyHead[nLevel] : pPrev->m_pReadyNext;
 
-			return true;
+		if (thread.m_pReadyNext == nullptr)
+		{
+			m_readyTail[nLevel] = &thread;
+		}
+		else
+		{
+			thread.m_pReadyNext->m_pReadyPrev = &thread;
 		}
 
-		memcpy((void *)&m_pCurrent->m_stack, (const void *)m_pCurrent->m_pEndStack, m_pCurrent->nStackSize);
+		if (pPrev == nullptr)
+		{
+			m_readyHead[nLevel] = &thread;
+		}
+		else
+		{
+			pPrev->m_pReadyNext = &thread;
+		}
 
-		longjmp(m_joinContext, 1);
+		thread.m_nReadyLevel = (uint8_t)nLevel;
+		thread.m_schedState  = SchedState::ready;
 
-		return false;
+		m_readyBitmap[nLevel / 32] |= 1u << (nLevel % 32);
+		m_readySummary |= 1u << (nLevel / 32);
 	}
 
-	size_t Thread::GetThreadCount()
+	inline void Thread::SchedDelaySwap(size_t nIndexA, size_t nIndexB)
 	{
-		return m_nNodeCounter;
-	}
+		Thread *pThread = m_delayHeap[nIndexA];
 
-	Thread::~Thread()
-	{
-		DetachThread(*this);
-	}
+		m_delayHeap[nIndexA] = m_delayHeap[nIndexB];
+		m_delayHeap[nIndexB] = pThread;
 
-	size_t Thread::GetStackSize()
-	{
-		return nStackSize;
+		m_delayHeap[nIndexA]->m_nSchedIndex = nIndexA;
+		m_delayHeap[nIndexB]->m_nSchedIndex = nIndexB;
 	}
 
-	size_t Thread::GetMaxStackSize()
+	void Thread::SchedDelayUp(size_t nIndex)
 	{
-		return m_nMaxStackSize;
-	}
+		while (nIndex > 0)
+		{
+			size_t nParent = (nIndex - 1) / 2;
 
-	Iterator<Thread> Thread::begin()
-	{
-		return Iterator<Thread>(m_pBegin);
+			if (!IsTimeBefore(m_delayHeap[nIndex]->m_nextEvent, m_delayHeap[nParent]->m_nextEvent))
+			{
+				break;
+			}
+
+			SchedDelaySwap(nIndex, nParent);
+			nIndex = nParent;
+		}
 	}
 
-	Iterator<Thread> Thread::end()
+	void Thread::SchedDelayDown(size_t nIndex)
 	{
-		return Iterator<Thread>(nullptr);
+		while (true)
+		{
+			size_t nChild = nIndex * 2 + 1;
+
+			if (nChild >= m_nDelayHeapSize)
+			{
+				break;
+			}
+
+			if (nChild + 1 < m_nDelayHeapSize && IsTimeBefore(m_delayHeap[nChild + 1]->m_nextEvent, m_delayHeap[nChild]->m_nextEvent))
+			{
+				nChild++;
+			}
+
+			if (!IsTimeBefore(m_delayHeap[nChild]->m_nextEvent, m_delayHeap[nIndex]->m_nextEvent))
+			{
+				break;
+			}
+
+			SchedDelaySwap(nIndex, nChild);
+			nIndex = nChild;
+		}
+	}
+
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE && defined(ATOMICX_SCHED_SIMD)
+
+	/*
+     * Best table entry in [nBegin, nEnd) for the key (nextEvent - nRef, -rank),
+     * replacing nBest only when strictly better, so earlier ranges win ties.
+     * Every lane keeps its own best and the first index reaching it, the lanes
+     * are then reduced with the lowest index breaking ties, as a scan would.
+     */
+	void Thread::SchedTableFind(size_t nBegin, size_t nEnd, atomicx_time nRef, int32_t &nBestRel, int32_t &nBestRank, size_t &nBest)
+	{
+		int32_t nRel  = INT32_MAX;
+		int32_t nRank = -1;
+		size_t nFound = nEnd;
+		size_t nIndex = nBegin;
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+		if (nEnd - nBegin >= 4)
+		{
+			int32_t laneRel[4];
+			int32_t laneRank[4];
+			int32_t laneIndex[4];
+
+#if defined(__SSE2__)
+			const __m128i vRef  = _mm_set1_epi32((int32_t)nRef);
+			const __m128i vStep = _mm_set1_epi32(4);
+			const __m128i vNone = _mm_set1_epi32(-1);
+
+			__m128i vBestRel   = _mm_set1_epi32(INT32_MAX);
+			__m128i vBestRank  = vNone;
+			__m128i vBestIndex = _mm_setzero_si128();
+			__m128i vIndex     = _mm_setr_epi32((int32_t)nIndex, (int32_t)nIndex + 1, (int32_t)nIndex + 2, (int32_t)nIndex + 3);
+
+			for (; nIndex + 4 <= nEnd; nIndex += 4)
+			{
+				__m128i vRel  = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)&m_schedNextEvent[nIndex]), vRef);
+				__m128i vRank = _mm_loadu_si128((const __m128i *)&m_schedRank[nIndex]);
+
+				// Rank -1 never beats the initial -1, so forever waiters drop out by themselves
+				__m128i vBetter = _mm_or_si128(_mm_and_si128(_mm_cmplt_epi32(vRel, vBestRel), _mm_cmpgt_epi32(vRank, vNone)),
+				                               _mm_and_si128(_mm_cmpeq_epi32(vRel, vBestRel), _mm_cmpgt_epi32(vRank, vBestRank)));
+
+				vBestRel   = _mm_or_si128(_mm_and_si128(vBetter, vRel), _mm_andnot_si128(vBetter, vBestRel));
+				vBestRank  = _mm_or_si128(_mm_and_si128(vBetter, vRank), _mm_andnot_si128(vBetter, vBestRank));
+				vBestIndex = _mm_or_si128(_mm_and_si128(vBetter, vIndex), _mm_andnot_si128(vBetter, vBestIndex));
+				vIndex     = _mm_add_epi32(vIndex, vStep);
+			}
+
+			_mm_storeu_si128((__m128i *)laneRel, vBestRel);
+			_mm_storeu_si128((__m128i *)laneRank, vBestRank);
+			_mm_storeu_si128((__m128i *)laneIndex, vBestIndex);
+#else
+			const int32x4_t vRef  = vdupq_n_s32((int32_t)nRef);
+			const int32x4_t vStep = vdupq_n_s32(4);
+			const int32x4_t vNone = vdupq_n_s32(-1);
+
+			int32x4_t vBestRel   = vdupq_n_s32(INT32_MAX);
+			int32x4_t vBestRank  = vNone;
+			int32x4_t vBestIndex = vdupq_n_s32(0);
+			const int32_t laneOffset[4] = {0, 1, 2, 3};
+
+			int32x4_t vIndex = vaddq_s32(vdupq_n_s32((int32_t)nIndex), vld1q_s32(laneOffset));
+
+			for (; nIndex + 4 <= nEnd; nIndex += 4)
+			{
+				int32x4_t vRel  = vsubq_s32(vld1q_s32((const int32_t *)&m_schedNextEvent[nIndex]), vRef);
+				int32x4_t vRank = vld1q_s32(&m_schedRank[nIndex]);
+
+				uint32x4_t vBetter = vorrq_u32(vandq_u32(vcltq_s32(vRel, vBestRel), vcgtq_s32(vRank, vNone)),
+				                               vandq_u32(vceqq_s32(vRel, vBestRel), vcgtq_s32(vRank, vBestRank)));
+
+				vBestRel   = vbslq_s32(vBetter, vRel, vBestRel);
+				vBestRank  = vbslq_s32(vBetter, vRank, vBestRank);
+				vBestIndex = vbslq_s32(vBetter, vIndex, vBestIndex);
+				vIndex     = vaddq_s32(vIndex, vStep);
+			}
+
+			vst1q_s32(laneRel, vBestRel);
+			vst1q_s32(laneRank, vBestRank);
+			vst1q_s32(laneIndex, vBestIndex);
+#endif
+
+			for (size_t nLane = 0; nLane < 4; nLane++)
+			{
+				if (laneRank[nLane] < 0)
+				{
+					continue;
+				}
+
+				if (laneRel[nLane] < nRel || (laneRel[nLane] == nRel && (laneRank[nLane] > nRank || (laneRank[nLane] == nRank && (size_t)laneIndex[nLane] < nFound))))
+				{
+					nRel   = laneRel[nLane];
+					nRank  = laneRank[nLane];
+					nFound = (size_t)laneIndex[nLane];
+				}
+			}
+		}
+#endif
+
+		// The tail, and every entry on targets without vector support
+		for (; nIndex < nEnd; nIndex++)
+		{
+			int32_t nEntryRel = (int32_t)(m_schedNextEvent[nIndex] - nRef);
+
+			if (m_schedRank[nIndex] >= 0 && (nEntryRel < nRel || (nEntryRel == nRel && m_schedRank[nIndex] > nRank)))
+			{
+				nRel   = nEntryRel;
+				nRank  = m_schedRank[nIndex];
+				nFound = nIndex;
+			}
+		}
+
+		if (nFound != nEnd && (nRel < nBestRel || (nRel == nBestRel && nRank > nBestRank)))
+		{
+			nBestRel  = nRel;
+			nBestRank = nRank;
+			nBest     = nFound;
+		}
+	}
+
+#endif
+
+	void Thread::SelectNext()
+	{
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+		Thread *pThread = SchedHeapNext();
+
+		if (pThread != nullptr)
+		{
+			m_pCurrent = pThread;
+		}
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+		// Same walk as the list, from the entry after the current thread, wrapping around
+		size_t nIndex = m_pCurrent->m_nSchedIndex;
+
+		if (nIndex >= m_nNodeCounter || m_schedThread[nIndex] != m_pCurrent)
+		{
+			nIndex = m_nNodeCounter - 1;
+		}
+
+#ifdef ATOMICX_SCHED_SIMD
+		// Keys are taken relative to the current thread, which wins any tie
+		int32_t nBestRel  = 0;
+		int32_t nBestRank = m_pCurrent->m_priority;
+		size_t nBest      = m_nNodeCounter;
+
+		SchedTableFind(nIndex + 1, m_nNodeCounter, m_pCurrent->m_nextEvent, nBestRel, nBestRank, nBest);
+		SchedTableFind(0, nIndex + 1, m_pCurrent->m_nextEvent, nBestRel, nBestRank, nBest);
+
+		if (nBest != m_nNodeCounter)
+		{
+			m_pCurrent = m_schedThread[nBest];
+		}
+#else
+		atomicx_time nextEvent = m_pCurrent->m_nextEvent;
+		int32_t nRank          = m_pCurrent->m_priority;
+		Thread *pThread        = m_pCurrent;
+
+		for (size_t nThreadCount = m_nNodeCounter; nThreadCount > 0; nThreadCount--)
+		{
+			nIndex = nIndex + 1 == m_nNodeCounter ? 0 : nIndex + 1;
+
+			if (m_schedRank[nIndex] >= 0
+			    && (IsTimeBefore(m_schedNextEvent[nIndex], nextEvent) || (m_schedNextEvent[nIndex] == nextEvent && m_schedRank[nIndex] > nRank)))
+			{
+				nextEvent = m_schedNextEvent[nIndex];
+				nRank     = m_schedRank[nIndex];
+				pThread   = m_schedThread[nIndex];
+			}
+		}
+
+		m_pCurrent = pThread;
+#endif
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_EDF
+		/*
+         * Due periodic threads by job deadline, aperiodic ones take the slack
+         * in list order, the earliest nextEvent only while nothing is due.
+         */
+		atomicx_time tm = GetTick();
+		Thread *pJob    = nullptr;
+		Thread *pSlack  = nullptr;
+		Thread *pNext   = nullptr;
+		Thread *pThread = m_pCurrent;
+
+		// The current thread comes first so it wins any tie, as in the list scan
+		for (size_t nThreadCount = m_nNodeCounter + 1; nThreadCount > 0; nThreadCount--)
+		{
+			if (!pThread->m_flags.noTimout)
+			{
+				if (IsTimeBefore(tm, pThread->m_nextEvent))
+				{
+					if (pNext == nullptr || IsScheduledBefore(*pThread, *pNext))
+					{
+						pNext = pThread;
+					}
+				}
+				else if (pThread->m_nPeriod > 0)
+				{
+					if (pJob == nullptr || IsDeadlineBefore(*pThread, *pJob))
+					{
+						pJob = pThread;
+					}
+				}
+				else if (pSlack == nullptr || IsScheduledBefore(*pThread, *pSlack))
+				{
+					pSlack = pThread;
+				}
+			}
+
+			pThread = pThread->pNext == nullptr ? m_pBegin : pThread->pNext;
+		}
+
+		if (pJob != nullptr)
+		{
+			m_pCurrent = pJob;
+		}
+		else if (pSlack != nullptr)
+		{
+			m_pCurrent = pSlack;
+		}
+		else if (pNext != nullptr)
+		{
+			m_pCurrent = pNext;
+		}
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+		m_nSchedTick = GetTick();
+
+		while (m_nDelayHeapSize > 0 && !IsTimeBefore(m_nSchedTick, m_delayHeap[0]->m_nextEvent))
+		{
+			Thread &thread = *m_delayHeap[0];
+
+			SchedUnlink(thread);
+			SchedReadyInsert(thread);
+		}
+
+		if (m_readySummary != 0)
+		{
+			size_t nWord  = 31 - __builtin_clz(m_readySummary);
+			size_t nLevel = nWord * 32 + 31 - __builtin_clz(m_readyBitmap[nWord]);
+
+			m_pCurrent = m_readyHead[nLevel];
+		}
+		else if (m_nDelayHeapSize > 0)
+		{
+			// Nothing due, the earliest one tells how long to sleep
+			m_pCurrent = m_delayHeap[0];
+		}
+#else
+		size_t nThreadCount = m_nNodeCounter;
+		Thread *pThread     = m_pCurrent;
+
+		while (nThreadCount--)
+		{
+			pThread = pThread->pNext == nullptr ? m_pBegin : pThread->pNext;
+
+			TRACE(KERNEL, pThread << "." << pThread->GetName() << ": Status: " << GetStatusName(pThread->m_status)
+			                      << ", nextEvent: " << pThread->m_nextEvent);
+
+			if (!pThread->m_flags.noTimout && IsScheduledBefore(*pThread, *m_pCurrent))
+			{
+				m_pCurrent = pThread;
+			}
+		}
+#endif
+	}
+
+	void Thread::Idle(atomicx_time nSleep)
+	{
+		TRACE_EVENT(sleepBegin, nullptr, m_pCurrent, Status::sleep, nSleep);
+
+#ifdef ATOMICX_ACCOUNTING
+		atomicx_time tm = GetTick();
+#endif
+
+#ifdef ATOMICX_REACTOR
+		if (m_nIoWaiters > 0)
+		{
+			PollIO(nSleep);
+		}
+		else
+#endif
+		{
+#ifdef ATOMICX_OUTSIDE_NOTIFY
+			WaitOutside(nSleep);
+#else
+			SleepTick(nSleep);
+#endif
+		}
+
+#ifdef ATOMICX_ACCOUNTING
+		m_nIdleTicks += GetTick() - tm;
+#endif
+
+		TRACE_EVENT(sleepEnd, nullptr, m_pCurrent, Status::sleep, 0);
+	}
+
+	void Thread::Scheduler()
+	{
+		atomicx_time tm;
+
+#ifdef ATOMICX_EVENT_TRACE
+		Thread *pPrevious = m_pCurrent;
+#endif
+
+#if defined(ATOMICX_MULTICORE) || defined(ATOMICX_REACTOR) || defined(ATOMICX_OUTSIDE_NOTIFY) || defined(ATOMICX_TIMERS)
+		/*
+         * Other instances, file descriptors, outside notifications and timer
+         * callbacks may wake threads up at any time: idle periods are spent
+         * where those wake ups are seen, and a thread waiting without timeout
+         * is not picked while they can still come.
+         */
+		while (true)
+		{
+			atomicx_time nSleep = (atomicx_time)-1;
+			bool bWakeable      = false;
+
+#ifdef ATOMICX_OUTSIDE_NOTIFY
+			bWakeable = true;
+
+#ifndef ATOMICX_MULTICORE
+			DrainOutside();
+#endif
+#endif
+
+#ifdef ATOMICX_MULTICORE
+			nSleep = ATOMICX_KERNEL_POLL;
+
+			m_kernel.Drain();
+#endif
+
+#ifdef ATOMICX_TIMERS
+			// Callbacks come first, they may wake threads due at the same tick
+			nSleep = Timer::Expire(nSleep);
+
+			bWakeable = bWakeable || Timer::m_nCount > 0;
+#endif
+
+#ifdef ATOMICX_MULTICORE
+			if (m_nNodeCounter == 0)
+			{
+				if (m_nTotalThreads.load() == 0)
+				{
+					m_pCurrent = nullptr;
+
+					return;
+				}
+
+				m_kernel.RequestSteal();
+
+				Idle(nSleep);
+
+				continue;
+			}
+
+			if (m_pCurrent == nullptr)
+			{
+				m_pCurrent = m_pBegin;
+			}
+
+			// Keeps m_pCurrent, the yielding thread, as its context is not saved yet
+			m_kernel.Donate();
+
+			bWakeable = bWakeable || m_nTotalThreads.load() > m_nNodeCounter;
+#endif
+
+			// Start from a thread that can run, a forever waiter would win and block the others
+			for (size_t nCount = m_nNodeCounter; nCount > 1 && m_pCurrent->m_flags.noTimout; nCount--)
+			{
+				m_pCurrent = GetCyclicalNext();
+			}
+
+			SelectNext();
+
+			tm = GetTick();
+
+#ifdef ATOMICX_REACTOR
+			// Ready descriptors are collected once per tick even when the CPU never goes idle
+			if (m_nIoWaiters > 0 && m_nLastPoll != tm)
+			{
+				m_nLastPoll = tm;
+
+				if (PollIO(0) > 0)
+				{
+					continue;
+				}
+			}
+
+			bWakeable = bWakeable || m_nIoWaiters > 0;
+#endif
+
+			// Nothing can release a forever waiter now, let it time out as usual
+			if (!m_pCurrent->m_flags.noTimout || !bWakeable)
+			{
+				if (!IsTimeBefore(tm, m_pCurrent->m_nextEvent))
+				{
+					break;
+				}
+
+				if (m_pCurrent->m_nextEvent - tm < nSleep)
+				{
+					nSleep = m_pCurrent->m_nextEvent - tm;
+				}
+			}
+
+#ifdef ATOMICX_MULTICORE
+			m_kernel.RequestSteal();
+#endif
+
+			Idle(nSleep);
+		}
+#else
+		// Start from a thread that can run, a forever waiter would win and time out
+		for (size_t nCount = m_nNodeCounter; nCount > 1 && m_pCurrent->m_flags.noTimout; nCount--)
+		{
+			m_pCurrent = GetCyclicalNext();
+		}
+
+		SelectNext();
+
+		TRACE(KERNEL, m_pCurrent << "." << m_pCurrent->GetName() << ": LEAVING Status: " << GetStatusName(m_pCurrent->m_status)
+		                         << ", nextEvent: " << m_pCurrent->m_nextEvent);
+
+		tm = GetTick();
+		if (IsTimeBefore(tm, m_pCurrent->m_nextEvent))
+		{
+			TRACE(KERNEL, "SLEEPING: " << m_pCurrent << "." << m_pCurrent->GetName() << ", Status;" << GetStatusName(m_pCurrent->m_status)
+			                           << ", tm: " << tm << ", next: " << m_pCurrent->m_nextEvent
+			                           << ", sleep: " << (int32_t)(m_pCurrent->m_nextEvent - tm));
+
+			Idle(m_pCurrent->m_nextEvent - tm);
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO || ATOMICX_SCHEDULER == ATOMICX_SCHED_EDF
+			// Threads of a higher level, or an earlier deadline, may have come due at the same time
+			SelectNext();
+#endif
+		}
+#endif
+
+		// Still in a wait list means nobody notified it before its deadline
+		if (m_pCurrent->m_pWaitList != nullptr)
+		{
+			m_pCurrent->m_pWaitList->Remove(*m_pCurrent);
+			m_pCurrent->m_status = Status::timeout;
+
+#ifdef ATOMICX_ACCOUNTING
+			m_pCurrent->m_nTimeouts++;
+#endif
+		}
+
+#ifdef ATOMICX_ACCOUNTING
+		m_pCurrent->m_nResumeTick = GetTick();
+#endif
+
+#ifdef ATOMICX_EVENT_TRACE
+		if (m_pCurrent != pPrevious)
+		{
+			TRACE_EVENT(contextSwitch, pPrevious, m_pCurrent, pPrevious != nullptr ? pPrevious->m_status : Status::none, 0);
+		}
+#endif
+        
+        m_pCurrent->m_flags.noTimout = false;
+		m_pCurrent->m_late = (int32_t)(m_pCurrent->m_nextEvent - GetTick());
+		m_pCurrent->UpdateSchedule();
+	}
+
+	void Thread::SetNice(atomicx_time nNice)
+	{
+		m_nice = nNice;
+	}
+
+	void Thread::SetPriority(uint8_t value)
+	{
+		bool bInherited = m_priority > m_basePriority;
+
+		m_basePriority = value;
+
+		if (!bInherited || value > m_priority)
+		{
+			m_priority = value;
+		}
+
+		UpdateSchedule();
+	}
+
+	bool Thread::Join()
+	{
+		m_pCurrent = m_pEnd;
+
+#ifdef ATOMICX_OUTSIDE_NOTIFY
+		OpenWakeFd();
+#endif
+
+#ifdef ATOMICX_MULTICORE
+		// An empty instance still runs, to take threads from the busy ones
+		m_kernel.Register();
+
+		if (m_nTotalThreads.load() > 0)
+#else
+		if (m_pCurrent != nullptr)
+#endif
+		{
+			m_pStartStack = GetStackPoint(); //&nStackPoint;
+
+			// Yield already ran the scheduler when it jumps back with JOIN_SCHEDULED
+			if (setjmp(m_joinContext) != JOIN_SCHEDULED)
+			{
+#ifndef ATOMICX_MULTICORE
+				if (m_nNodeCounter == 0)
+				{
+					return false;
+				}
+#endif
+
+				// m_pCurrent = GetCyclicalNext ();
+				Thread::Scheduler();
+			}
+
+			// Tasks run right here on the Join stack, there is nothing to save or restore
+			while (m_pCurrent != nullptr && m_pCurrent->m_bTask)
+			{
+				m_pCurrent->run();
+
+				Thread::Scheduler();
+			}
+
+#ifdef ATOMICX_MULTICORE
+			if (m_pCurrent == nullptr)
+			{
+				m_kernel.Unregister();
+
+				return false;
+			}
+#endif
+
+			TRACE(KERNEL, "------------------------------------");
+			TRACE(KERNEL, m_pCurrent->GetName()
+			                  << "_" << (size_t)m_pCurrent << ": St [" << GetStatusName(m_pCurrent->m_status) << "]");
+			TRACE(KERNEL, "Stack size: " << m_pCurrent->nStackSize << ", Max: " << m_pCurrent->m_nMaxStackSize
+			                             << ", Occupied: " << (100 * m_pCurrent->nStackSize) / (m_pCurrent->m_nMaxStackSize) << "%");
+
+			if (m_pCurrent->m_status == Status::starting)
+			{
+				m_pCurrent->m_status = Status::running;
+
+#ifdef ATOMICX_DEDICATED_STACK
+				Bootstrap();
+#else
+				m_pCurrent->run();
+
+				Finish();
+#endif
+			}
+			else
+			{
+				Resume();
+			}
+		}
+
+		TRACE(TRACE, "NO THREAD TO RUN.... #" << m_nNodeCounter);
+
+		return false;
+	}
+
+#ifdef ATOMICX_DEDICATED_STACK
+
+	/*
+     * Dedicated stack mode: the thread is started once on its own stack[N]
+     * through ucontext, from there on Yield and Join only swap registers
+     * with setjmp/longjmp, nothing is copied.
+     */
+
+	void Thread::Bootstrap()
+	{
+		ucontext_t context;
+
+		getcontext(&context);
+
+		context.uc_stack.ss_sp   = (void *)&m_pCurrent->m_stack;
+		context.uc_stack.ss_size = m_pCurrent->m_nMaxStackSize;
+		context.uc_link          = nullptr;
+
+		makecontext(&context, Launch, 0);
+
+		setcontext(&context);
+	}
+
+	void Thread::Launch()
+	{
+		m_pCurrent->run();
+
+#if ATOMICX_STACK_CHECK != ATOMICX_STACK_CHECK_NONE
+		// A thread that never yielded is only checked here
+		if (m_pCurrent->m_stack != ATOMICX_STACK_CANARY)
+		{
+			Overflow();
+		}
+#endif
+
+		Finish();
+	}
+
+#endif
+
+#if ATOMICX_STACK_CHECK != ATOMICX_STACK_CHECK_NONE
+
+	void Thread::Overflow()
+	{
+		Thread &thread = *m_pCurrent;
+
+		TRACE(CRITICAL, "Stack overflow: " << thread.nStackSize << ", Max: " << thread.m_nMaxStackSize);
+
+#if ATOMICX_STACK_CHECK == ATOMICX_STACK_CHECK_ABORT
+		abort();
+#elif ATOMICX_STACK_CHECK == ATOMICX_STACK_CHECK_HOOK
+		StackOverflow(thread);
+#endif
+
+		// Its stack cannot be saved, it will never run again
+		Halt(thread);
+
+		m_pCurrent = m_pBegin;
+
+		longjmp(m_joinContext, 1);
+	}
+
+#endif
+
+	void Thread::Halt(Thread &thread)
+	{
+		if (thread.m_pWaitList != nullptr)
+		{
+			thread.m_pWaitList->Remove(thread);
+		}
+
+		DetachThread(thread);
+		thread.m_status = Status::halted;
+
+#ifdef ATOMICX_MULTICORE
+		m_nTotalThreads--;
+#endif
+	}
+
+	void Thread::Finish()
+	{
+		if (m_pCurrent->OnExit())
+		{
+			m_pCurrent->m_status = Status::starting;
+		}
+		else
+		{
+			Halt(*m_pCurrent);
+
+			m_pCurrent = m_pBegin;
+		}
+
+		longjmp(m_joinContext, 1);
+	}
+
+	bool Thread::OnExit()
+	{
+		return true;
+	}
+
+	bool Thread::Start()
+	{
+		if (m_status != Status::halted)
+		{
+			return false;
+		}
+
+		m_status         = Status::starting;
+		m_nextEvent      = GetTick();
+		m_flags.noTimout = false;
+		m_priority       = m_basePriority;
+		m_pLocksHeld     = nullptr;
+		m_nSharedHeld    = 0;
+
+#ifdef ATOMICX_PERIODIC
+		m_nRelease  = m_nextEvent;
+		m_nDeadline = m_nRelease + m_nRelativeDeadline;
+#endif
+
+		if (!AttachThread(*this))
+		{
+			m_status = Status::halted;
+
+			return false;
+		}
+
+#ifdef ATOMICX_MULTICORE
+		m_nTotalThreads++;
+#endif
+
+		return true;
+	}
+
+	bool Thread::Stop()
+	{
+		if (this == m_pCurrent || m_status == Status::halted)
+		{
+			return false;
+		}
+
+		Halt(*this);
+
+		return true;
+	}
+
+	void Thread::Resume()
+	{
+		if (m_pCurrent->m_status == Status::starting || m_pCurrent->m_bTask)
+		{
+			longjmp(m_joinContext, JOIN_SCHEDULED);
+		}
+
+		longjmp(m_pCurrent->m_context, 1);
+	}
+
+	bool Thread::Yield(atomicx_time tm, Status st)
+	{
+		Thread *pThread = m_pCurrent;
+
+		m_pCurrent->m_pEndStack = GetStackPoint();
+#ifdef ATOMICX_DEDICATED_STACK
+		m_pCurrent->nStackSize = (volatile uint8_t *)&m_pCurrent->m_stack + m_pCurrent->m_nMaxStackSize - m_pCurrent->m_pEndStack;
+#else
+		m_pCurrent->nStackSize = m_pStartStack - m_pCurrent->m_pEndStack + sizeof(size_t);
+#endif
+
+		TRACE(KERNEL, "Stack size: " << m_pCurrent->nStackSize << ", Max: " << m_pCurrent->m_nMaxStackSize
+		                             << ", Occupied: " << (100 * m_pCurrent->nStackSize) / (m_pCurrent->m_nMaxStackSize) << "%");
+
+#if ATOMICX_STACK_CHECK != ATOMICX_STACK_CHECK_NONE
+		if (m_pCurrent->nStackSize > m_pCurrent->m_nMaxStackSize
+#ifdef ATOMICX_DEDICATED_STACK
+		    || m_pCurrent->m_stack != ATOMICX_STACK_CANARY
+#endif
+		)
+		{
+			Overflow();
+		}
+#endif
+
+#ifdef ATOMICX_ACCOUNTING
+		m_pCurrent->m_nRunTicks += GetTick() - m_pCurrent->m_nResumeTick;
+		m_pCurrent->m_nYields++;
+
+		if (m_pCurrent->nStackSize > m_pCurrent->m_nPeakStackSize)
+		{
+			m_pCurrent->m_nPeakStackSize = m_pCurrent->nStackSize;
+		}
+#endif
+
+		if (st == Status::now)
+		{
+			tm = GetTick();
+		}
+#ifdef ATOMICX_PERIODIC
+		else if (st == Status::periodic)
+		{
+			// Absolute, set by WaitNextPeriod, nothing read from the clock may shift it
+			tm = m_pCurrent->m_nRelease;
+		}
+#endif
+		else
+		{
+			tm = GetTick() + (tm ? tm : m_pCurrent->m_nice);
+		}
+
+		m_pCurrent->m_status    = st;
+		m_pCurrent->m_nextEvent = tm;
+		m_pCurrent->UpdateSchedule();
+
+#ifdef ATOMICX_DEDICATED_STACK
+		/*
+         * A scheduler pass may sleep, stack[N] is not sized for any of it:
+         * schedule on the Join stack, which resumes right here when it
+         * picks this thread again. Nothing is copied, that costs two
+         * register swaps.
+         */
+		if (setjmp(pThread->m_context) == 0)
+		{
+			longjmp(m_joinContext, 1);
+		}
+
+		NOTRACE(KERNEL, (size_t)m_pCurrent << ": RETURNED from Join.");
+
+		return true;
+#else
+		/*
+         * Schedule right here, below the thread frames, so when the same
+         * thread is picked again its stack image is still resident and
+         * neither the copies nor the jumps through Join are needed.
+         */
+		Scheduler();
+
+		if (m_pCurrent == pThread)
+		{
+			return true;
+		}
+
+		if (setjmp(pThread->m_context) != 0)
+		{
+			m_pCurrent->nStackSize = m_pStartStack - m_pCurrent->m_pEndStack;
+			memcpy((void *)m_pCurrent->m_pEndStack, (const void *)&m_pCurrent->m_stack, m_pCurrent->nStackSize);
+
+			NOTRACE(KERNEL, (size_t)m_pCurrent << ": RETURNED from Join.");
+
+			return true;
+		}
+
+		memcpy((void *)&pThread->m_stack, (const void *)pThread->m_pEndStack, pThread->nStackSize);
+
+		Resume();
+
+		return false;
+#endif
+	}
+
+	size_t Thread::PostNotify(NotifyChennelType channel, void *pEndPoint, Message msg, atomicx::Notify howMany)
+	{
+		size_t nNotified = SafeNotify(Status::wait, channel, pEndPoint, msg, howMany);
+
+#ifdef ATOMICX_MULTICORE
+		if (nNotified == 0)
+		{
+			nNotified = ForwardNotify(channel, pEndPoint, msg, howMany);
+		}
+#endif
+
+		return nNotified;
+	}
+
+	bool Thread::SafeBlock(WaitList &waitList, NotifyChennelType channel, void *pEndPoint, size_t nType, Timeout &tm, Status st)
+	{
+		Thread &thread = *m_pCurrent;
+
+		thread.m_msgChannel         = channel;
+		thread.m_pWaitEndPoint      = pEndPoint;
+		thread.m_messagectl.type    = nType;
+		thread.m_messagectl.message = 0;
+		thread.m_flags.noTimout     = !tm.CanTimeout();
+
+		waitList.Push(thread);
+
+		TRACE_EVENT(wait, &thread, nullptr, st, pEndPoint);
+
+		Yield(tm.GetRemaining(), st);
+
+		return thread.m_status != Status::timeout;
+	}
+
+#ifdef ATOMICX_REACTOR
+	size_t Thread::PollIO(atomicx_time nSleep)
+	{
+		struct epoll_event events[ATOMICX_REACTOR_EVENTS];
+
+		int nReady = epoll_wait(m_nEpoll, events, ATOMICX_REACTOR_EVENTS, TicksToMs(nSleep));
+
+		// EINTR included, the scheduler just looks again
+		if (nReady <= 0)
+		{
+			return 0;
+		}
+
+		size_t nWoken = 0;
+
+		// Woken by the kernel, not by the thread that happens to be current
+		Thread *pCurrent = m_pCurrent;
+		m_pCurrent       = nullptr;
+
+		for (int nCount = 0; nCount < nReady; nCount++)
+		{
+#ifdef ATOMICX_OUTSIDE_WAKE
+			// The wake fd, the scheduler drains the outside queue next
+			if (events[nCount].data.ptr == nullptr)
+			{
+				ClearWakeFd();
+
+				continue;
+			}
+#endif
+
+			Thread &thread = *(Thread *)events[nCount].data.ptr;
+
+			if (thread.m_pWaitList == &m_ioWaitList)
+			{
+				thread.WakeUp(events[nCount].events);
+				nWoken++;
+			}
+		}
+
+		m_pCurrent = pCurrent;
+
+		return nWoken;
+	}
+
+	bool Thread::WaitIO(int nFd, uint32_t nEvents, Timeout &tm)
+	{
+		if (m_nEpoll < 0)
+		{
+			if ((m_nEpoll = epoll_create1(EPOLL_CLOEXEC)) < 0)
+			{
+				return false;
+			}
+
+#ifdef ATOMICX_OUTSIDE_WAKE
+			// Idle time is spent in epoll_wait while threads wait on I/O, NotifyFromOutside must end it too
+			struct epoll_event wake = {};
+
+			wake.events   = EPOLLIN;
+			wake.data.ptr = nullptr;
+
+			if (m_nWakeFd >= 0)
+			{
+				epoll_ctl(m_nEpoll, EPOLL_CTL_ADD, m_nWakeFd, &wake);
+			}
+#endif
+		}
+
+		struct epoll_event event = {};
+
+		// One shot, it is disarmed as soon as it fires and left registered for the next wait
+		event.events   = nEvents | EPOLLONESHOT;
+		event.data.ptr = this;
+
+		if (epoll_ctl(m_nEpoll, EPOLL_CTL_ADD, nFd, &event) != 0 && (errno != EEXIST || epoll_ctl(m_nEpoll, EPOLL_CTL_MOD, nFd, &event) != 0))
+		{
+			return false;
+		}
+
+		m_nIoWaiters++;
+
+		bool bReady = SafeBlock(m_ioWaitList, NotifyChennelType::KERNEL, (void *)(intptr_t)nFd, nEvents, tm, Status::sysWait);
+
+		m_nIoWaiters--;
+
+		// Still armed, must not fire for a thread that may be gone by then
+		if (!bReady)
+		{
+			epoll_ctl(m_nEpoll, EPOLL_CTL_DEL, nFd, nullptr);
+		}
+
+		return bReady;
+	}
+
+	bool Thread::WaitReadable(int nFd, Timeout tm)
+	{
+		return WaitIO(nFd, EPOLLIN, tm);
+	}
+
+	bool Thread::WaitWritable(int nFd, Timeout tm)
+	{
+		return WaitIO(nFd, EPOLLOUT, tm);
+	}
+#endif
+
+#ifdef ATOMICX_OUTSIDE_NOTIFY
+	void Thread::OpenWakeFd()
+	{
+#ifdef ATOMICX_OUTSIDE_WAKE
+		if (m_nWakeFd >= 0)
+		{
+			return;
+		}
+
+		int nFd       = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		int nExpected = -1;
+
+		// Another instance may be opening it as well
+		if (nFd >= 0 && !m_nWakeFd.compare_exchange_strong(nExpected, nFd))
+		{
+			close(nFd);
+		}
+#endif
+	}
+
+#ifdef ATOMICX_OUTSIDE_WAKE
+	void Thread::ClearWakeFd()
+	{
+		uint64_t nCount;
+
+		while (read(m_nWakeFd, &nCount, sizeof(nCount)) > 0)
+		{
+		}
+	}
+
+#endif
+
+	void Thread::WaitOutside(atomicx_time nSleep)
+	{
+#ifdef ATOMICX_OUTSIDE_WAKE
+		if (m_nWakeFd >= 0)
+		{
+			struct pollfd wake = {};
+
+			wake.fd     = m_nWakeFd;
+			wake.events = POLLIN;
+
+			if (poll(&wake, 1, TicksToMs(nSleep)) > 0)
+			{
+				ClearWakeFd();
+			}
+
+			return;
+		}
+#endif
+
+		/*
+         * No wake fd: nothing would end a forever sleep, so the outside queue
+         * is polled every tick, see OUTSIDE NOTIFY in atomicx.hpp
+         */
+		SleepTick(nSleep != (atomicx_time)-1 ? nSleep : 1);
+	}
+
+	bool Thread::PostOutside(void *pEndPoint, Message msg, atomicx::Notify howMany)
+	{
+		bool bQueued = false;
+
+#ifdef ATOMICX_MULTICORE
+		Kernel::Envelope envelope;
+
+		envelope.request   = Kernel::Request::notify;
+		envelope.pFrom     = nullptr;
+		envelope.pThread   = nullptr;
+		envelope.channel   = NotifyChennelType::USER;
+		envelope.pEndPoint = pEndPoint;
+		envelope.msg       = msg;
+		envelope.howMany   = howMany;
+
+		for (auto &kernel : Kernel::m_kernels)
+		{
+			Kernel *pKernel = kernel.load(std::memory_order_acquire);
+
+			if (pKernel != nullptr && pKernel->m_inbox.Push(envelope))
+			{
+				bQueued = true;
+			}
+		}
+#else
+		bQueued = m_outsideQueue.Push({pEndPoint, msg, howMany});
+#endif
+
+#ifdef ATOMICX_OUTSIDE_WAKE
+		int nFd = m_nWakeFd.load(std::memory_order_relaxed);
+
+		if (bQueued && nFd >= 0)
+		{
+			// May run in a signal handler, errno is the interrupted code's
+			int nErrno     = errno;
+			uint64_t nWake = 1;
+
+			if (write(nFd, &nWake, sizeof(nWake)) < 0)
+			{
+				// Counter full, a wake up is pending anyway
+			}
+
+			errno = nErrno;
+		}
+#endif
+
+		return bQueued;
+	}
+
+#ifndef ATOMICX_MULTICORE
+	void Thread::DrainOutside()
+	{
+		OutsideNotify notify;
+
+		while (m_outsideQueue.Pop(notify))
+		{
+			SafeNotify(Status::wait, NotifyChennelType::USER, notify.pEndPoint, notify.msg, notify.howMany);
+		}
+	}
+#endif
+#endif
+
+	size_t Thread::GetThreadCount()
+	{
+		return m_nNodeCounter;
+	}
+
+	Thread::Thread(atomicx_time nNice)
+	    : m_nice(nNice)
+	    , m_nextEvent(GetTick())
+	    , m_nMaxStackSize(0)
+	    , m_stack(m_nNoStack)
+	    , m_bTask(true)
+	{
+		AttachNew();
+	}
+
+	void Thread::AttachNew()
+	{
+		if (!AttachThread(*this))
+		{
+			// Same as a failed Start(), the thread exists but will never run
+			m_status = Status::halted;
+
+			TRACE(ERROR, "Scheduler full, thread " << this << " left halted");
+			return;
+		}
+
+#ifdef ATOMICX_MULTICORE
+		m_nTotalThreads++;
+#endif
+	}
+
+	Thread::~Thread()
+	{
+		// Halted threads are already out
+		if (m_status != Status::halted)
+		{
+			DetachThread(*this);
+
+#ifdef ATOMICX_MULTICORE
+			m_nTotalThreads--;
+#endif
+		}
+	}
+
+	size_t Thread::GetStackSize()
+	{
+		return nStackSize;
+	}
+
+	size_t Thread::GetMaxStackSize()
+	{
+		return m_nMaxStackSize;
+	}
+
+#ifdef ATOMICX_STACK_WATERMARK
+	size_t Thread::GetStackWatermark()
+	{
+		volatile uint8_t *pStack = (volatile uint8_t *)&m_stack;
+		size_t nUntouched        = 0;
+
+#ifdef ATOMICX_DEDICATED_STACK
+		// The stack grows down from the end of the buffer
+		while (nUntouched < m_nMaxStackSize && pStack[nUntouched] == ATOMICX_STACK_PATTERN)
+		{
+			nUntouched++;
+		}
+#else
+		// The saved image is copied from the start of the buffer
+		while (nUntouched < m_nMaxStackSize && pStack[m_nMaxStackSize - nUntouched - 1] == ATOMICX_STACK_PATTERN)
+		{
+			nUntouched++;
+		}
+#endif
+
+		return m_nMaxStackSize - nUntouched;
+	}
+#endif
+
+	Iterator<Thread> Thread::begin()
+	{
+		return Iterator<Thread>(m_pBegin);
+	}
+
+	Iterator<Thread> Thread::end()
+	{
+		return Iterator<Thread>(nullptr);
+	}
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+	Thread *Thread::operator++()
+	{
+		return GetNextAttached(*this);
+	}
+#endif
+
+	Status Thread::GetStatus()
+	{
+		return m_status;
+	}
+
+	atomicx_time Thread::GetNice()
+	{
+		return m_nice;
+	}
+
+	uint8_t Thread::GetPriority()
+	{
+		return m_priority;
+	}
+
+	atomicx_time Thread::GetNextEvent()
+	{
+		return m_nextEvent;
+	}
+
+	int32_t Thread::GetLate()
+	{
+		return m_late;
+	}
+
+#ifdef ATOMICX_PERIODIC
+
+	void Thread::SetPeriod(atomicx_time nPeriod, atomicx_time nDeadline)
+	{
+		m_nPeriod           = nPeriod;
+		m_nRelativeDeadline = nDeadline ? nDeadline : nPeriod;
+		m_nRelease          = GetTick();
+		m_nDeadline         = m_nRelease + m_nRelativeDeadline;
+	}
+
+	bool Thread::WaitNextPeriod()
+	{
+		Thread &thread = *m_pCurrent;
+
+		if (thread.m_nPeriod == 0)
+		{
+			return false;
+		}
+
+		atomicx_time tm = GetTick();
+
+		if (IsTimeBefore(thread.m_nDeadline, tm))
+		{
+			thread.m_nDeadlineMisses++;
+		}
+
+		thread.m_nRelease += thread.m_nPeriod;
+
+		// Jobs that could only end late are dropped, the next ones keep the phase
+		while (IsTimeBefore(thread.m_nRelease + thread.m_nRelativeDeadline, tm))
+		{
+			thread.m_nRelease += thread.m_nPeriod;
+			thread.m_nDeadlineMisses++;
+		}
+
+		thread.m_nDeadline = thread.m_nRelease + thread.m_nRelativeDeadline;
+
+		bool bReturn = Yield(0, Status::periodic);
+
+		// Set when it was dispatched, negative if it started after its release
+		if (thread.m_late < thread.m_nWorstLate)
+		{
+			thread.m_nWorstLate = thread.m_late;
+		}
+
+		return bReturn;
+	}
+
+	atomicx_time Thread::GetPeriod()
+	{
+		return m_nPeriod;
+	}
+
+	atomicx_time Thread::GetDeadline()
+	{
+		return m_nDeadline;
+	}
+
+	size_t Thread::GetDeadlineMisses()
+	{
+		return m_nDeadlineMisses;
+	}
+
+	int32_t Thread::GetWorstLate()
+	{
+		return m_nWorstLate;
+	}
+
+#endif
+
+#ifdef ATOMICX_ACCOUNTING
+
+	atomicx_time Thread::GetRunTicks()
+	{
+		return m_nRunTicks;
+	}
+
+	size_t Thread::GetYieldCount()
+	{
+		return m_nYields;
+	}
+
+	size_t Thread::GetTimeoutCount()
+	{
+		return m_nTimeouts;
+	}
+
+	size_t Thread::GetWakeUpsSent()
+	{
+		return m_nWakeUpsSent;
+	}
+
+	size_t Thread::GetWakeUpsReceived()
+	{
+		return m_nWakeUpsReceived;
+	}
+
+	size_t Thread::GetPeakStackSize()
+	{
+		return m_nPeakStackSize;
+	}
+
+	atomicx_time Thread::GetIdleTicks()
+	{
+		return m_nIdleTicks;
+	}
+
+#endif
+
+#ifdef ATOMICX_EVENT_TRACE
+
+	void Thread::DumpTrace(void (*pWriter)(const void *pData, size_t nSize, void *pContext), void *pContext)
+	{
+		size_t nEvents = m_nTraceCount < ATOMICX_EVENT_TRACE_SIZE ? m_nTraceCount : ATOMICX_EVENT_TRACE_SIZE;
+
+		TraceFileHeader header = {};
+
+		header.nMagic   = ATOMICX_TRACE_MAGIC;
+		header.nVersion = ATOMICX_TRACE_VERSION;
+		header.nThreads = (uint32_t)m_nNodeCounter;
+		header.nEvents  = (uint32_t)nEvents;
+		header.nLost    = m_nTraceCount - nEvents;
+
+		pWriter(&header, sizeof(header), pContext);
+
+		for (Thread *pThread = m_pBegin; pThread != nullptr; pThread = GetNextAttached(*pThread))
+		{
+			TraceFileThread thread = {};
+
+			thread.nId = (uintptr_t)pThread;
+			strncpy(thread.name, pThread->GetName(), sizeof(thread.name) - 1);
+
+			pWriter(&thread, sizeof(thread), pContext);
+		}
+
+		for (size_t nCount = m_nTraceCount - nEvents; nCount < m_nTraceCount; nCount++)
+		{
+			TraceRecord &record  = m_traceRing[nCount % ATOMICX_EVENT_TRACE_SIZE];
+			TraceFileEvent event = {};
+
+			event.nTick  = record.nTick;
+			event.nFrom  = (uintptr_t)record.pFrom;
+			event.nTo    = (uintptr_t)record.pTo;
+			event.nValue = record.nValue;
+			event.type   = (uint8_t)record.type;
+			event.status = (uint8_t)record.status;
+
+			pWriter(&event, sizeof(event), pContext);
+		}
+	}
+
+	void Thread::ClearTrace()
+	{
+		m_nTraceCount = 0;
+	}
+
+#endif
+
+#ifdef ATOMICX_MULTICORE
+
+	Kernel &Thread::GetKernel()
+	{
+		return m_kernel;
+	}
+
+	void Thread::SetPinned(bool bPinned)
+	{
+		m_bPinned = bPinned;
+	}
+
+	bool Thread::IsPinned()
+	{
+		return m_bPinned;
+	}
+
+	size_t Thread::ForwardNotify(NotifyChennelType channel, void *pEndPoint, Message msg, atomicx::Notify howMany)
+	{
+		Kernel::Envelope envelope;
+		size_t nQueued = 0;
+
+		envelope.request   = Kernel::Request::notify;
+		envelope.pFrom     = &m_kernel;
+		envelope.pThread   = nullptr;
+		envelope.channel   = channel;
+		envelope.pEndPoint = pEndPoint;
+		envelope.msg       = msg;
+		envelope.howMany   = howMany;
+
+		for (auto &kernel : Kernel::m_kernels)
+		{
+			Kernel *pKernel = kernel.load(std::memory_order_acquire);
+
+			if (pKernel != nullptr && pKernel != &m_kernel && pKernel->m_inbox.Push(envelope))
+			{
+				nQueued++;
+			}
+		}
+
+		return nQueued;
+	}
+
+	/*
+        KERNEL
+    */
+
+	size_t Kernel::GetThreadCount()
+	{
+		return m_nThreads.load(std::memory_order_relaxed);
+	}
+
+	size_t Kernel::GetStolenCount()
+	{
+		return m_nStolen;
+	}
+
+	void Kernel::Register()
+	{
+		if (m_nIndex < ATOMICX_MAX_KERNELS)
+		{
+			return;
+		}
+
+		size_t nIndex = m_nKernels.fetch_add(1);
+
+		if (nIndex < ATOMICX_MAX_KERNELS)
+		{
+			m_nIndex = nIndex;
+			m_kernels[m_nIndex].store(this, std::memory_order_release);
+		}
+	}
+
+	void Kernel::Unregister()
+	{
+		if (m_nIndex < ATOMICX_MAX_KERNELS)
+		{
+			m_kernels[m_nIndex].store(nullptr, std::memory_order_release);
+		}
+	}
+
+	void Kernel::Drain()
+	{
+		Envelope envelope;
+
+		while (m_inbox.Pop(envelope))
+		{
+			if (envelope.request == Request::migrate)
+			{
+				if (Thread::AttachThread(*envelope.pThread))
+				{
+					m_nStolen++;
+
+					continue;
+				}
+
+				// Full here, back to the donor, or to this inbox for the next drain
+				TRACE(KERNEL, "No room for " << envelope.pThread << ", returning it to " << envelope.pFrom);
+
+				Kernel *pFrom  = envelope.pFrom;
+				envelope.pFrom = this;
+
+				if (!pFrom->m_inbox.Push(envelope))
+				{
+					if (!m_inbox.Push(envelope))
+					{
+						TRACE(CRITICAL, "Both inboxes full, " << envelope.pThread << " is lost");
+					}
+
+					break;
+				}
+			}
+			else
+			{
+				Thread::SafeNotify(Status::wait, envelope.channel, envelope.pEndPoint, envelope.msg, envelope.howMany);
+			}
+		}
+	}
+
+	void Kernel::RequestSteal()
+	{
+		Kernel *pVictim = nullptr;
+		size_t nMost    = m_nThreads.load(std::memory_order_relaxed) + 1;
+
+		for (auto &kernel : m_kernels)
+		{
+			Kernel *pKernel = kernel.load(std::memory_order_acquire);
+
+			if (pKernel != nullptr && pKernel != this && pKernel->m_nThreads.load(std::memory_order_relaxed) > nMost)
+			{
+				pVictim = pKernel;
+				nMost   = pKernel->m_nThreads.load(std::memory_order_relaxed);
+			}
+		}
+
+		if (pVictim != nullptr)
+		{
+			Kernel *pNone = nullptr;
+
+			pVictim->m_pThief.compare_exchange_strong(pNone, this);
+		}
+	}
+
+	void Kernel::Donate()
+	{
+		if (m_pThief.load(std::memory_order_relaxed) == nullptr)
+		{
+			return;
+		}
+
+		Kernel *pThief = m_pThief.exchange(nullptr);
+
+		if (pThief == nullptr)
+		{
+			return;
+		}
+
+		size_t nThreads     = m_nThreads.load(std::memory_order_relaxed);
+		size_t nThiefThreads = pThief->m_nThreads.load(std::memory_order_relaxed);
+
+		// Steal half, so a burst of new threads spreads in one request
+		size_t nGive = nThreads > nThiefThreads ? (nThreads - nThiefThreads) / 2 : 0;
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+		size_t nCapacity = ATOMICX_SCHED_HEAP_SIZE;
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE || ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+		size_t nCapacity = ATOMICX_MAX_THREADS;
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP || ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE || ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+		// Never more than the thief can attach, Drain still returns what it cannot
+		size_t nRoom = nThiefThreads < nCapacity ? nCapacity - nThiefThreads : 0;
+
+		if (nGive > nRoom)
+		{
+			nGive = nRoom;
+		}
+#endif
+
+		Thread *pNext = Thread::m_pBegin;
+
+		while (nGive > 0 && pNext != nullptr)
+		{
+			Thread *pThread = pNext;
+			pNext           = Thread::GetNextAttached(*pThread);
+
+			// Pinned, blocked or holding a lock, it depends on objects of this instance
+			if (pThread == Thread::m_pCurrent || pThread->m_bPinned || pThread->m_pWaitList != nullptr || pThread->m_pLocksHeld != nullptr || pThread->m_nSharedHeld > 0)
+			{
+				continue;
+			}
+
+#ifndef ATOMICX_DEDICATED_STACK
+			// Once started, its stack image is only valid below this instance's Join
+			if (pThread->m_status != Status::starting && !pThread->m_bTask)
+			{
+				continue;
+			}
+#endif
+
+			Envelope envelope;
+
+			envelope.request   = Request::migrate;
+			envelope.pFrom     = this;
+			envelope.pThread   = pThread;
+			envelope.channel   = Thread::NotifyChennelType::KERNEL;
+			envelope.pEndPoint = nullptr;
+			envelope.msg       = {0, 0};
+			envelope.howMany   = Notify::one;
+
+			Thread::DetachThread(*pThread);
+
+			if (!pThief->m_inbox.Push(envelope))
+			{
+				Thread::AttachThread(*pThread);
+
+				break;
+			}
+
+			TRACE(KERNEL, "Migrating " << pThread << " to " << pThief);
+
+			nGive--;
+		}
+	}
+
+#endif
+
+	/*
+        TASK
+    */
+
+	Task::Task(atomicx_time nNice)
+	    : Thread(nNice)
+	{
+	}
+
+	void Task::run()
+	{
+		m_bScheduled = false;
+
+		Step();
+
+		if (!m_bScheduled)
+		{
+			m_status    = Status::sleep;
+			m_nextEvent = GetTick() + m_nice;
+		}
+
+#ifdef ATOMICX_ACCOUNTING
+		m_nRunTicks += GetTick() - m_nResumeTick;
+		m_nYields++;
+#endif
+
+		UpdateSchedule();
+	}
+
+	void Task::Sleep(atomicx_time tm)
+	{
+		m_status     = Status::sleep;
+		m_nextEvent  = GetTick() + tm;
+		m_bScheduled = true;
+	}
+
+	void Task::AwaitEndPoint(void *pEndPoint, size_t nType, Timeout &tm)
+	{
+		SafeWait(NotifyChennelType::USER, pEndPoint, nType, tm);
+
+		// A notifier may be blocked in syncWait for someone to wait
+		SafeNotify(Status::syncWait, NotifyChennelType::USER, pEndPoint, {.message = 0, .type = nType}, atomicx::Notify::one);
+
+		TRACE_EVENT(wait, this, nullptr, Status::wait, pEndPoint);
+
+		m_messagectl.message = 0;
+		m_status             = Status::wait;
+		m_nextEvent          = GetTick() + tm.GetRemaining();
+		m_bScheduled         = true;
+	}
+
+	size_t Task::GetMessage()
+	{
+		return m_messagectl.message;
+	}
+
+#ifdef ATOMICX_TIMERS
+
+	/*
+        TIMER
+    */
+
+	ATOMICX_KERNEL_LOCAL Timer *Timer::m_heap[ATOMICX_TIMER_HEAP_SIZE] = {};
+	ATOMICX_KERNEL_LOCAL size_t Timer::m_nCount                        = 0;
+
+	Timer::Timer(Callback pCallback, void *pContext)
+	    : m_pCallback(pCallback)
+	    , m_pContext(pContext)
+	{
+	}
+
+	Timer::~Timer()
+	{
+		Stop();
+	}
+
+	bool Timer::Start(atomicx_time nDelay, atomicx_time nPeriod)
+	{
+		return StartAt(Thread::GetTick() + nDelay, nPeriod);
+	}
+
+	bool Timer::StartAt(atomicx_time nDeadline, atomicx_time nPeriod)
+	{
+		Thread::PinCurrent();
+
+		Stop();
+
+		if (m_nCount >= ATOMICX_TIMER_HEAP_SIZE)
+		{
+			return false;
+		}
+
+		m_nDeadline  = nDeadline;
+		m_nPeriod    = nPeriod;
+		m_nOverruns  = 0;
+		m_nHeapIndex = m_nCount++;
+
+		m_heap[m_nHeapIndex] = this;
+		HeapUp(m_nHeapIndex);
+
+		return true;
+	}
+
+	bool Timer::Stop()
+	{
+		if (!IsActive())
+		{
+			return false;
+		}
+
+		Remove();
+
+		return true;
+	}
+
+	bool Timer::IsActive()
+	{
+		return m_nHeapIndex < m_nCount && m_heap[m_nHeapIndex] == this;
+	}
+
+	atomicx_time Timer::GetDeadline()
+	{
+		return m_nDeadline;
+	}
+
+	atomicx_time Timer::GetPeriod()
+	{
+		return m_nPeriod;
+	}
+
+	size_t Timer::GetOverruns()
+	{
+		return m_nOverruns;
+	}
+
+	atomicx_time Timer::Expire(atomicx_time nSleep)
+	{
+		atomicx_time tm = Thread::GetTick();
+
+		// Called by the kernel, not by the thread that happens to be current
+		Thread *pCurrent   = Thread::m_pCurrent;
+		Thread::m_pCurrent = nullptr;
+
+		// Deadlines reached while the callbacks run are left for the next pass
+		while (m_nCount > 0 && !IsTimeBefore(tm, m_heap[0]->m_nDeadline))
+		{
+			Timer &timer = *m_heap[0];
+
+			if (timer.m_nPeriod > 0)
+			{
+				// From the deadline, not from now, a late callback does not shift the next ones
+				timer.m_nDeadline += timer.m_nPeriod;
+
+				while (!IsTimeBefore(tm, timer.m_nDeadline))
+				{
+					timer.m_nDeadline += timer.m_nPeriod;
+					timer.m_nOverruns++;
+				}
+
+				HeapDown(0);
+			}
+			else
+			{
+				timer.Remove();
+			}
+
+			// Already re-armed or removed, the callback may Start or Stop it freely
+			timer.m_pCallback(timer, timer.m_pContext);
+		}
+
+		Thread::m_pCurrent = pCurrent;
+
+		if (m_nCount > 0)
+		{
+			tm = Thread::GetTick();
+
+			atomicx_time nNext = IsTimeBefore(tm, m_heap[0]->m_nDeadline) ? m_heap[0]->m_nDeadline - tm : 0;
+
+			if (nNext < nSleep)
+			{
+				nSleep = nNext;
+			}
+		}
+
+		return nSleep;
+	}
+
+	void Timer::Remove()
+	{
+		size_t nIndex = m_nHeapIndex;
+
+		HeapSwap(nIndex, --m_nCount);
+
+		// The last timer took its place, it may have to go either way
+		if (nIndex < m_nCount)
+		{
+			Timer *pMoved = m_heap[nIndex];
+
+			HeapUp(nIndex);
+			HeapDown(pMoved->m_nHeapIndex);
+		}
+	}
+
+	inline void Timer::HeapSwap(size_t nIndex, size_t nOther)
+	{
+		Timer *pTimer = m_heap[nIndex];
+
+		m_heap[nIndex] = m_heap[nOther];
+		m_heap[nOther] = pTimer;
+
+		m_heap[nIndex]->m_nHeapIndex = nIndex;
+		m_heap[nOther]->m_nHeapIndex = nOther;
+	}
+
+	void Timer::HeapUp(size_t nIndex)
+	{
+		while (nIndex > 0)
+		{
+			size_t nParent = (nIndex - 1) / 2;
+
+			if (!IsTimeBefore(m_heap[nIndex]->m_nDeadline, m_heap[nParent]->m_nDeadline))
+			{
+				break;
+			}
+
+			HeapSwap(nIndex, nParent);
+			nIndex = nParent;
+		}
+	}
+
+	void Timer::HeapDown(size_t nIndex)
+	{
+		while (true)
+		{
+			size_t nChild = nIndex * 2 + 1;
+
+			if (nChild >= m_nCount)
+			{
+				break;
+			}
+
+			if (nChild + 1 < m_nCount && IsTimeBefore(m_heap[nChild + 1]->m_nDeadline, m_heap[nChild]->m_nDeadline))
+			{
+				nChild++;
+			}
+
+			if (!IsTimeBefore(m_heap[nChild]->m_nDeadline, m_heap[nIndex]->m_nDeadline))
+			{
+				break;
+			}
+
+			HeapSwap(nIndex, nChild);
+			nIndex = nChild;
+		}
+	}
+
+#endif
+
+	/*
+        MUTEX
+    */
+
+	bool Mutex::Lock(Timeout tm)
+	{
+		Thread::PinCurrent();
+
+		if (!m_bExclusiveLock && m_nSharedLockCount == 0 && m_waitList.IsEmpty())
+		{
+			m_bExclusiveLock = true;
+			SetOwner(*Thread::m_pCurrent);
+
+			return true;
+		}
+
+		m_nExclusiveWaiters++;
+
+		Inherit(*Thread::m_pCurrent);
+
+		if (!Thread::SafeBlock(m_waitList, Thread::NotifyChennelType::MUTEX, this, exclusive, tm, Status::locked))
+		{
+			TRACE(LOCK, "Timeout on Lock");
+
+			m_nExclusiveWaiters--;
+
+			if (m_pOwner != nullptr)
+			{
+				Reinherit(*m_pOwner);
+			}
+
+			// Readers queued behind this writer may go now
+			Dispatch();
+
+			return false;
+		}
+
+		return true;
 	}
 
-	Status Thread::GetStatus()
+	void Mutex::Unlock()
 	{
-		return m_status;
+		if (m_pOwner != nullptr)
+		{
+			Thread &owner  = *m_pOwner;
+			Mutex **ppHeld = &owner.m_pLocksHeld;
+
+			while (*ppHeld != nullptr && *ppHeld != this)
+			{
+				ppHeld = &(*ppHeld)->m_pNextHeld;
+			}
+
+			if (*ppHeld != nullptr)
+			{
+				*ppHeld = m_pNextHeld;
+			}
+
+			m_pOwner    = nullptr;
+			m_pNextHeld = nullptr;
+
+			// Only the locks still held keep lending their waiters' priority
+			Reinherit(owner);
+		}
+
+		m_bExclusiveLock = false;
+
+		Dispatch();
 	}
 
-	atomicx_time Thread::GetNice()
+	bool Mutex::SharedLock(Timeout tm)
 	{
-		return m_nice;
+		Thread::PinCurrent();
+
+		if (!m_bExclusiveLock && m_nExclusiveWaiters == 0)
+		{
+			m_nSharedLockCount++;
+			Thread::m_pCurrent->m_nSharedHeld++;
+
+			return true;
+		}
+
+		Inherit(*Thread::m_pCurrent);
+
+		if (!Thread::SafeBlock(m_waitList, Thread::NotifyChennelType::MUTEX, this, shared, tm, Status::locked))
+		{
+			TRACE(LOCK, "Timeout on SharedLock");
+
+			if (m_pOwner != nullptr)
+			{
+				Reinherit(*m_pOwner);
+			}
+
+			return false;
+		}
+
+		return true;
 	}
 
-	atomicx_time Thread::GetNextEvent()
+	void Mutex::SharedUnlock()
 	{
-		return m_nextEvent;
+		if (m_nSharedLockCount > 0)
+		{
+			m_nSharedLockCount--;
+		}
+
+		if (Thread::m_pCurrent->m_nSharedHeld > 0)
+		{
+			Thread::m_pCurrent->m_nSharedHeld--;
+		}
+
+		Dispatch();
 	}
 
-	int32_t Thread::GetLate()
+	bool Mutex::GetExclusiveLockStatus()
 	{
-		return m_late;
+		return m_bExclusiveLock;
+	}
+
+	size_t Mutex::GetSharedLockCount()
+	{
+		return m_nSharedLockCount;
+	}
+
+	size_t Mutex::GetInheritanceCount()
+	{
+		return m_nInheritanceCount;
+	}
+
+	void Mutex::Inherit(Thread &waiter)
+	{
+		Mutex *pMutex = this;
+
+		// Shared owners are not tracked, only an exclusive owner can inherit
+		while (pMutex != nullptr && pMutex->m_pOwner != nullptr && pMutex->m_pOwner != &waiter)
+		{
+			Thread &owner = *pMutex->m_pOwner;
+			bool bInherited = false;
+
+			if (owner.m_priority < waiter.m_priority)
+			{
+				owner.m_priority = waiter.m_priority;
+				bInherited       = true;
+			}
+
+			// Pulling the next event of a blocked owner would fake its timeout
+			if (owner.m_pWaitList == nullptr && IsTimeBefore(waiter.m_nextEvent, owner.m_nextEvent))
+			{
+				owner.m_nextEvent = waiter.m_nextEvent;
+				bInherited        = true;
+			}
+
+			if (!bInherited)
+			{
+				break;
+			}
+
+			TRACE(LOCK, "Inherited by " << &owner << ", priority: " << (int)owner.m_priority << ", nextEvent: " << owner.m_nextEvent);
+
+			owner.UpdateSchedule();
+			pMutex->m_nInheritanceCount++;
+
+			pMutex = owner.m_pWaitList != nullptr && owner.m_msgChannel == Thread::NotifyChennelType::MUTEX ?
+			             (Mutex *)owner.m_pWaitEndPoint :
+			             nullptr;
+		}
+	}
+
+	void Mutex::SetOwner(Thread &thread)
+	{
+		m_pOwner            = &thread;
+		m_pNextHeld         = thread.m_pLocksHeld;
+		thread.m_pLocksHeld = this;
+
+		for (Thread *pThread = m_waitList.GetFirst(); pThread != nullptr; pThread = pThread->m_pWaitNext)
+		{
+			if (thread.m_priority < pThread->m_priority)
+			{
+				thread.m_priority = pThread->m_priority;
+				m_nInheritanceCount++;
+			}
+		}
+	}
+
+	void Mutex::Reinherit(Thread &owner)
+	{
+		Thread *pOwner = &owner;
+
+		while (pOwner != nullptr)
+		{
+			uint8_t priority = pOwner->m_basePriority;
+
+			for (Mutex *pMutex = pOwner->m_pLocksHeld; pMutex != nullptr; pMutex = pMutex->m_pNextHeld)
+			{
+				for (Thread *pThread = pMutex->m_waitList.GetFirst(); pThread != nullptr; pThread = pThread->m_pWaitNext)
+				{
+					if (priority < pThread->m_priority)
+					{
+						priority = pThread->m_priority;
+					}
+				}
+			}
+
+			if (pOwner->m_priority == priority)
+			{
+				break;
+			}
+
+			TRACE(LOCK, "Given back by " << pOwner << ", priority: " << (int)priority);
+
+			pOwner->m_priority = priority;
+			pOwner->UpdateSchedule();
+
+			// It may be lending the old priority to the owner of the mutex it waits on
+			pOwner = pOwner->m_pWaitList != nullptr && pOwner->m_msgChannel == Thread::NotifyChennelType::MUTEX ?
+			             ((Mutex *)pOwner->m_pWaitEndPoint)->m_pOwner :
+			             nullptr;
+		}
+	}
+
+	void Mutex::Dispatch()
+	{
+		Thread *pThread;
+
+		while (!m_bExclusiveLock && (pThread = m_waitList.GetFirst()) != nullptr)
+		{
+			if (pThread->m_messagectl.type == exclusive)
+			{
+				if (m_nSharedLockCount > 0)
+				{
+					break;
+				}
+
+				m_bExclusiveLock = true;
+				m_nExclusiveWaiters--;
+
+				m_waitList.Remove(*pThread);
+				SetOwner(*pThread);
+			}
+			else
+			{
+				m_nSharedLockCount++;
+				pThread->m_nSharedHeld++;
+			}
+
+			TRACE(LOCK, "Handing over to " << pThread << ", type: " << pThread->m_messagectl.type);
+
+			pThread->WakeUp(pThread->m_messagectl.type);
+		}
+	}
+
+	/*
+        SMART MUTEX
+    */
+
+	SmartMutex::SmartMutex(Mutex &mutex)
+	    : m_mutex(mutex)
+	{
+	}
+
+	SmartMutex::~SmartMutex()
+	{
+		if (m_bLocked)
+		{
+			m_mutex.Unlock();
+		}
+		else if (m_bShared)
+		{
+			m_mutex.SharedUnlock();
+		}
+	}
+
+	bool SmartMutex::Lock(Timeout tm)
+	{
+		if (m_bLocked || m_bShared)
+		{
+			return false;
+		}
+
+		return (m_bLocked = m_mutex.Lock(tm));
+	}
+
+	void SmartMutex::Unlock()
+	{
+		if (m_bLocked)
+		{
+			m_mutex.Unlock();
+			m_bLocked = false;
+		}
+	}
+
+	bool SmartMutex::SharedLock(Timeout tm)
+	{
+		if (m_bLocked || m_bShared)
+		{
+			return false;
+		}
+
+		return (m_bShared = m_mutex.SharedLock(tm));
+	}
+
+	void SmartMutex::SharedUnlock()
+	{
+		if (m_bShared)
+		{
+			m_mutex.SharedUnlock();
+			m_bShared = false;
+		}
+	}
+
+	bool SmartMutex::IsLocked()
+	{
+		return m_bLocked;
+	}
+
+	bool SmartMutex::IsShared()
+	{
+		return m_bShared;
+	}
+
+	/*
+        SEMAPHORE
+    */
+
+	Semaphore::Semaphore(size_t nInitial, size_t nMax)
+	    : m_nCount(nInitial < nMax ? nInitial : nMax), m_nMax(nMax)
+	{
+	}
+
+	bool Semaphore::Acquire(Timeout tm)
+	{
+		Thread::PinCurrent();
+
+		// Units are handed over on Release, a positive count means nobody is waiting
+		if (m_nCount > 0)
+		{
+			m_nCount--;
+
+			return true;
+		}
+
+		m_nWaiting++;
+
+		if (!Thread::SafeBlock(m_waitList, Thread::NotifyChennelType::SEMAPHORE, this, 0, tm, Status::wait))
+		{
+			TRACE(LOCK, "Timeout on Acquire");
+
+			m_nWaiting--;
+
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Semaphore::TryAcquire()
+	{
+		Thread::PinCurrent();
+
+		if (m_nCount > 0)
+		{
+			m_nCount--;
+
+			return true;
+		}
+
+		return false;
+	}
+
+	bool Semaphore::Release(size_t nCount)
+	{
+		Thread::PinCurrent();
+
+		size_t nHanded = nCount < m_nWaiting ? nCount : m_nWaiting;
+
+		if (nCount - nHanded > m_nMax - m_nCount)
+		{
+			return false;
+		}
+
+		m_nCount += nCount - nHanded;
+		m_nWaiting -= nHanded;
+
+		for (; nHanded > 0; nHanded--)
+		{
+			Thread *pThread = m_waitList.GetFirst();
+
+			TRACE(LOCK, "Handing over to " << pThread);
+
+			pThread->WakeUp(1);
+		}
+
+		return true;
+	}
+
+	size_t Semaphore::GetCount()
+	{
+		return m_nCount;
+	}
+
+	size_t Semaphore::GetWaiting()
+	{
+		return m_nWaiting;
+	}
+
+	/*
+        CONDITION VARIABLE
+    */
+
+	bool ConditionVariable::Wait(Mutex &mutex, Timeout tm)
+	{
+		Thread::PinCurrent();
+
+		mutex.Unlock();
+
+		bool bNotified = Thread::SafeBlock(m_waitList, Thread::NotifyChennelType::CONDITION, this, 0, tm, Status::wait);
+
+		mutex.Lock();
+
+		return bNotified;
+	}
+
+	size_t ConditionVariable::NotifyOne()
+	{
+		return Wake(1);
+	}
+
+	size_t ConditionVariable::NotifyAll()
+	{
+		return Wake(SIZE_MAX);
+	}
+
+	size_t ConditionVariable::Wake(size_t nMax)
+	{
+		Thread::PinCurrent();
+
+		size_t nWoken = 0;
+		Thread *pThread;
+
+		while (nWoken < nMax && (pThread = m_waitList.GetFirst()) != nullptr)
+		{
+			pThread->WakeUp(1);
+			nWoken++;
+		}
+
+		return nWoken;
+	}
+
+	/*
+        BARRIER
+    */
+
+	Barrier::Barrier(size_t nParties)
+	    : m_nParties(nParties > 0 ? nParties : 1)
+	{
+	}
+
+	bool Barrier::Wait(Timeout tm)
+	{
+		Thread::PinCurrent();
+
+		if (++m_nArrived == m_nParties)
+		{
+			Thread *pThread;
+
+			m_nArrived = 0;
+			m_nGeneration++;
+
+			TRACE(LOCK, "Barrier released, generation: " << m_nGeneration);
+
+			while ((pThread = m_waitList.GetFirst()) != nullptr)
+			{
+				pThread->WakeUp(m_nGeneration);
+			}
+
+			return true;
+		}
+
+		if (!Thread::SafeBlock(m_waitList, Thread::NotifyChennelType::BARRIER, this, m_nGeneration, tm, Status::wait))
+		{
+			TRACE(LOCK, "Timeout on Barrier");
+
+			// Still the same generation, or the release would have woken it
+			m_nArrived--;
+
+			return false;
+		}
+
+		return true;
+	}
+
+	size_t Barrier::GetParties()
+	{
+		return m_nParties;
+	}
+
+	size_t Barrier::GetArrived()
+	{
+		return m_nArrived;
+	}
+
+	size_t Barrier::GetGeneration()
+	{
+		return m_nGeneration;
 	}
 
 } // namespace atomicx
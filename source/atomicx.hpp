@@ -14,11 +14,354 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <new>
+
+#if defined(ATOMICX_MULTICORE) || defined(ATOMICX_OUTSIDE_NOTIFY)
+#include <atomic>
+#endif
+
 /* Official version */
 #define ATOMICX_VERSION "1.3.0"
 #define ATOMIC_VERSION_LABEL "AtomicX v" ATOMICX_VERSION " built at " __TIMESTAMP__
 
-typedef uint32_t atomicx_time;
+// ------------------------------------------------------
+// TIME BASE
+//
+// Define -DATOMICX_TIME_TYPE=<unsigned type> to size the
+// . tick (uint32_t) and -DATOMICX_TICKS_PER_MS=<n> to tell
+// . how many GetTick ticks make 1 ms (1), ex
+// .    -DATOMICX_TIME_TYPE=uint64_t -DATOMICX_TICKS_PER_MS=1000
+// . for a microsecond GetTick. Deadlines are compared with
+// . serial number arithmetic, the tick may wrap around as
+// . long as no deadline is more than half the type's range
+// . away from the current tick.
+// ------------------------------------------------------
+
+#ifndef ATOMICX_TIME_TYPE
+#define ATOMICX_TIME_TYPE uint32_t
+#endif
+
+#ifndef ATOMICX_TICKS_PER_MS
+#define ATOMICX_TICKS_PER_MS 1
+#endif
+
+typedef ATOMICX_TIME_TYPE atomicx_time;
+
+// ------------------------------------------------------
+// SCHEDULER BACKEND
+//
+// TO USE, define -DATOMICX_SCHEDULER=<BACKEND> where
+// . backend is any of the ATOMICX_SCHED_* below, ex
+// .    -DATOMICX_SCHEDULER=ATOMICX_SCHED_HEAP
+// .
+// . ATOMICX_SCHED_LIST  (default) linear scan of all
+// .                     threads on every context switch
+// . ATOMICX_SCHED_HEAP  min-heap keyed on nextEvent and
+// .                     priority, O(log n) per switch,
+// .                     holds up to ATOMICX_SCHED_HEAP_SIZE
+// .                     threads; the current thread still
+// .                     wins a tie, other tied threads run
+// .                     in the order they were re-keyed
+// .                     instead of list order
+// . ATOMICX_SCHED_TABLE static table of ATOMICX_MAX_THREADS
+// .                     entries in attach order, holding
+// .                     nextEvent, priority and noTimout,
+// .                     replaces the thread linked list so
+// .                     every scan walks contiguous memory
+// .
+// . ATOMICX_SCHED_PRIO  strict priority, a thread due now
+// .                     always runs before any lower one and
+// .                     nextEvent only orders a level; one
+// .                     ready list per level, the highest
+// .                     found in a bitmap with count leading
+// .                     zeros, threads not due yet wait in a
+// .                     heap of ATOMICX_MAX_THREADS entries
+// . ATOMICX_SCHED_EDF   list scan, the due periodic thread
+// .                     with the earliest job deadline runs
+// .                     first, aperiodic threads only take
+// .                     the slack; turns ATOMICX_PERIODIC on
+// .
+// . With ATOMICX_SCHED_TABLE, define -DATOMICX_SCHED_SIMD
+// . (hosts, 32-bit atomicx_time) to run the table scan as
+// . an SSE2 or NEON reduction, 4 threads per step; other
+// . targets keep the scalar scan.
+// .
+// . ATOMICX_PRIO_LEVELS  levels of ATOMICX_SCHED_PRIO (32,
+// .                      up to 256), higher priorities share
+// .                      the top level
+// ------------------------------------------------------
+
+#define ATOMICX_SCHED_LIST  0
+#define ATOMICX_SCHED_HEAP  1
+#define ATOMICX_SCHED_TABLE 2
+#define ATOMICX_SCHED_PRIO  3
+#define ATOMICX_SCHED_EDF   4
+
+#ifndef ATOMICX_SCHEDULER
+#define ATOMICX_SCHEDULER ATOMICX_SCHED_LIST
+#endif
+
+#ifndef ATOMICX_SCHED_HEAP_SIZE
+#define ATOMICX_SCHED_HEAP_SIZE 64
+#endif
+
+#ifndef ATOMICX_MAX_THREADS
+#define ATOMICX_MAX_THREADS 16
+#endif
+
+#ifndef ATOMICX_PRIO_LEVELS
+#define ATOMICX_PRIO_LEVELS 32
+#endif
+
+// ------------------------------------------------------
+// CONTEXT SWITCH
+//
+// By default threads run on the Join stack and Yield
+// . copies the live stack slice to and from the
+// . stack[N] given to the Thread constructor.
+// . Define -DATOMICX_DEDICATED_STACK (POSIX hosts only)
+// . to run every thread directly on its own stack[N],
+// . switching registers only. stack[N] must then hold
+// . the whole run() call chain, libc calls included, the
+// . scheduler runs on the Join stack and adds nothing.
+// .
+// . ATOMICX_MIN_STACK_SIZE  smallest stack[N], in bytes,
+// .                         a Thread builds with, checked
+// .                         at compile time (4096 with
+// .                         dedicated stacks, 0 otherwise)
+// ------------------------------------------------------
+
+// ------------------------------------------------------
+// MULTI-CORE
+//
+// Define -DATOMICX_MULTICORE (hosts with C++11 threads)
+// . to run one kernel instance per OS thread: every
+// . thread calling Thread::Join gets its own run queue,
+// . wait queues and current thread, so N pthreads can
+// . each run a Join loop. Idle instances steal threads
+// . from the busiest one, through lock-free inboxes.
+// .
+// . Migration takes any ready thread that is not pinned,
+// . blocked or holding a Mutex, shared or exclusive, when
+// . ATOMICX_DEDICATED_STACK is also defined, otherwise
+// . only threads not yet started. Notify, when no local
+// . thread waits on the endpoint, is queued to the other
+// . instances. Mutex and the other synchronisation objects
+// . must stay on one instance: a thread is pinned by
+// . SetPinned or as soon as it uses one of them or a Timer.
+// .
+// . A thread that moved resumes on another OS thread: the
+// . compiler may keep a thread_local address across a call
+// . (GCC PR 26461), so such a thread must not hold one over
+// . Yield or any call that blocks. The kernel reaches its
+// . instance state through out-of-line calls after every
+// . switch, GetKernel is safe to call again.
+// .
+// . ATOMICX_MAX_KERNELS        max Join loops (16)
+// . ATOMICX_KERNEL_INBOX_SIZE  inbox entries (64)
+// . ATOMICX_KERNEL_POLL        max ticks an instance sleeps
+// .                            before checking its inbox (1)
+// ------------------------------------------------------
+
+#ifdef ATOMICX_MULTICORE
+#define ATOMICX_KERNEL_LOCAL thread_local
+
+#ifndef ATOMICX_MAX_KERNELS
+#define ATOMICX_MAX_KERNELS 16
+#endif
+
+#ifndef ATOMICX_KERNEL_INBOX_SIZE
+#define ATOMICX_KERNEL_INBOX_SIZE 64
+#endif
+
+#ifndef ATOMICX_KERNEL_POLL
+#define ATOMICX_KERNEL_POLL 1
+#endif
+#else
+#define ATOMICX_KERNEL_LOCAL
+#endif
+
+// ------------------------------------------------------
+// WAIT QUEUES
+//
+// Blocked threads are kept in ATOMICX_WAIT_BUCKETS wait
+// . lists hashed by endpoint and channel, so a Notify
+// . only visits threads waiting on the same bucket.
+// . Use -DATOMICX_WAIT_BUCKETS=1 to save RAM on small
+// . MCUs, every bucket costs two pointers.
+// ------------------------------------------------------
+
+#ifndef ATOMICX_WAIT_BUCKETS
+#define ATOMICX_WAIT_BUCKETS 8
+#endif
+
+// ------------------------------------------------------
+// I/O REACTOR
+//
+// Define -DATOMICX_REACTOR (Linux hosts) to let threads
+// . block on file descriptors with WaitReadable and
+// . WaitWritable, the kernel then spends its idle time in
+// . one epoll_wait bounded by the next thread's nextEvent
+// . instead of SleepTick.
+// . ATOMICX_REACTOR_EVENTS   events taken per epoll_wait (16)
+// . epoll timeouts are converted with ATOMICX_TICKS_PER_MS
+// ------------------------------------------------------
+
+#ifndef ATOMICX_REACTOR_EVENTS
+#define ATOMICX_REACTOR_EVENTS 16
+#endif
+
+// ------------------------------------------------------
+// OUTSIDE NOTIFY
+//
+// Define -DATOMICX_OUTSIDE_NOTIFY (C++11 atomics) to let
+// . OS threads, signal handlers and ISRs wake threads in
+// . Wait with Thread::NotifyFromOutside, it only pushes
+// . into a lock-free queue drained by the scheduler, it
+// . never blocks or touches the thread list.
+// . On Linux it also writes an eventfd the idle kernel
+// . waits on, cutting its sleep short. Elsewhere the
+// . message is seen once SleepTick returns, and with
+// . every thread waiting without timeout the idle kernel
+// . has no wake up to wait for: it then polls the queue
+// . with 1 tick SleepTick calls, a busy wait that costs
+// . power, so give such waits a timeout there.
+// . ATOMICX_OUTSIDE_QUEUE_SIZE  queued notifications (32)
+// ------------------------------------------------------
+
+#ifndef ATOMICX_OUTSIDE_QUEUE_SIZE
+#define ATOMICX_OUTSIDE_QUEUE_SIZE 32
+#endif
+
+#if defined(ATOMICX_OUTSIDE_NOTIFY) && defined(__linux__)
+#define ATOMICX_OUTSIDE_WAKE
+#endif
+
+// ------------------------------------------------------
+// THREAD POOL
+//
+// ThreadPool<N, StackWords> keeps N threads with their
+// . stacks in place, Spawn copies a callable into a free
+// . one, so nothing is allocated at run time.
+// . ATOMICX_POOL_CALLABLE_SIZE  bytes a callable may take,
+// .                             lambda captures included
+// .                             (4 pointers)
+// ------------------------------------------------------
+
+#ifndef ATOMICX_POOL_CALLABLE_SIZE
+#define ATOMICX_POOL_CALLABLE_SIZE (4 * sizeof(void *))
+#endif
+
+// ------------------------------------------------------
+// SOFTWARE TIMERS
+//
+// Define -DATOMICX_TIMERS to have Timer callbacks, one
+// . shot or periodic, called by the scheduler itself, no
+// . stack per timer. Periodic deadlines are absolute,
+// . deadline += period, so late callbacks never add up
+// . to drift. Pending timers are kept in a min-heap of up
+// . to ATOMICX_TIMER_HEAP_SIZE per kernel instance (16).
+// ------------------------------------------------------
+
+#ifndef ATOMICX_TIMER_HEAP_SIZE
+#define ATOMICX_TIMER_HEAP_SIZE 16
+#endif
+
+// ------------------------------------------------------
+// PERIODIC THREADS
+//
+// Define -DATOMICX_PERIODIC to give threads absolute
+// . release times and a deadline per job: SetPeriod
+// . releases the first job, WaitNextPeriod ends it and
+// . sleeps till release += period, so execution time and
+// . lateness never drift the rate. A job ending past its
+// . deadline, or a release dropped because its deadline
+// . passed while the previous job overran, counts as a
+// . deadline miss.
+// ------------------------------------------------------
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_EDF && !defined(ATOMICX_PERIODIC)
+#define ATOMICX_PERIODIC
+#endif
+
+// ------------------------------------------------------
+// STACK CHECK
+//
+// Yield checks the stack in use against stack[N] before
+// . saving it, ATOMICX_STACK_CHECK selects what happens
+// . to a thread that outgrew it:
+// .   ATOMICX_STACK_CHECK_NONE   no check (old behaviour)
+// .   ATOMICX_STACK_CHECK_HALT   thread halted (default)
+// .   ATOMICX_STACK_CHECK_HOOK   Thread::StackOverflow is
+// .                              called, then thread halted
+// .   ATOMICX_STACK_CHECK_ABORT  abort()
+// . A halted thread is detached, its stack is never saved.
+// . With ATOMICX_DEDICATED_STACK the thread already ran on
+// . the memory below stack[N], it is only caught late: the
+// . far end word of stack[N] is a guard, written on creation
+// . and checked on every Yield and when run() returns.
+// .
+// . Define -DATOMICX_STACK_WATERMARK to fill stack[N] with
+// . ATOMICX_STACK_PATTERN on creation, GetStackWatermark
+// . then tells the most it ever used.
+// ------------------------------------------------------
+
+#define ATOMICX_STACK_CHECK_NONE 0
+#define ATOMICX_STACK_CHECK_HALT 1
+#define ATOMICX_STACK_CHECK_HOOK 2
+#define ATOMICX_STACK_CHECK_ABORT 3
+
+#ifndef ATOMICX_STACK_CHECK
+#define ATOMICX_STACK_CHECK ATOMICX_STACK_CHECK_HALT
+#endif
+
+#ifndef ATOMICX_STACK_PATTERN
+#define ATOMICX_STACK_PATTERN 0xA5
+#endif
+
+// Guard word, ATOMICX_STACK_PATTERN in every byte so the watermark fill sets it too
+#define ATOMICX_STACK_CANARY ((size_t)(0x0101010101010101ULL * ATOMICX_STACK_PATTERN))
+
+#ifndef ATOMICX_MIN_STACK_SIZE
+#ifdef ATOMICX_DEDICATED_STACK
+#define ATOMICX_MIN_STACK_SIZE 4096
+#else
+#define ATOMICX_MIN_STACK_SIZE 0
+#endif
+#endif
+
+// ------------------------------------------------------
+// ACCOUNTING
+//
+// Define -DATOMICX_ACCOUNTING to keep cumulative counters
+// . per thread: ticks running, Yield calls, timeouts,
+// . wake ups sent and received and the stack peak, plus
+// . the ticks the kernel spent idle. Costs two
+// . GetTick calls per context switch.
+// ------------------------------------------------------
+
+// ------------------------------------------------------
+// EVENT TRACE
+//
+// Define -DATOMICX_EVENT_TRACE to record context switches,
+// . notify, wait and sleep into a fixed binary ring of
+// . ATOMICX_EVENT_TRACE_SIZE records (512), no allocation
+// . and no formatting. Thread::DumpTrace writes it out
+// . through a user function, tools/trace2json converts a
+// . dump into Chrome trace JSON (chrome://tracing, Perfetto).
+// . Compiled out, TRACE_EVENT expands to nothing.
+// ------------------------------------------------------
+
+#ifndef ATOMICX_EVENT_TRACE_SIZE
+#define ATOMICX_EVENT_TRACE_SIZE 512
+#endif
+
+#ifdef ATOMICX_EVENT_TRACE
+#define TRACE_EVENT(type, pFrom, pTo, status, value) \
+	Thread::RecordEvent(TraceType::type, pFrom, pTo, status, (size_t)(value))
+#else
+#define TRACE_EVENT(type, pFrom, pTo, status, value)
+#endif
 
 // ------------------------------------------------------
 // LOG FACILITIES
@@ -39,7 +382,8 @@ typedef uint32_t atomicx_time;
 #include <iostream>
 #define TRACE(i, x)                                                                                          \
 	if (DBGLevel::i <= DBGLevel::_DEBUG)                                                                     \
-	std::cout << Thread::GetCurrent() << "(" << Thread::GetCurrent()->GetName() << ")[" << #i << "] "        \
+	std::cout << Thread::GetCurrent() << "("                                                                 \
+	          << (Thread::GetCurrent() != nullptr ? Thread::GetCurrent()->GetName() : "kernel") << ")[" << #i << "] " \
 	          << "(" << __FUNCTION__ << ", " << __FILE_NAME__ << ":" << __LINE__ << "):  " << x << std::endl \
 	          << std::flush
 #else
@@ -67,6 +411,19 @@ namespace atomicx
 		&___var;                        \
 	})
 
+	/**
+	 * @brief Tells if tick a comes before tick b, still right after the tick wraps around
+	 *
+	 * @param a     Tick to test
+	 * @param b     Tick to compare against
+	 *
+	 * @return true if a is earlier than b
+	 */
+	inline bool IsTimeBefore(atomicx_time a, atomicx_time b)
+	{
+		return (atomicx_time)(a - b) > (atomicx_time)((atomicx_time)-1 >> 1);
+	}
+
 	enum class Status : uint8_t
 	{
 		none        = 0,
@@ -76,6 +433,7 @@ namespace atomicx
 		timeout     = 14,
 		halted      = 15,
 		paused      = 16,
+		periodic    = 17,
 		locked      = 100,
 		running     = 200,
 		now         = 201,
@@ -99,6 +457,49 @@ namespace atomicx
 
 	const char *GetStatusName(Status st);
 
+	enum class TraceType : uint8_t
+	{
+		contextSwitch, // from -> to, status: why from left
+		notify,        // from woke to, value: message
+		wait,          // from blocked, value: endpoint
+		sleepBegin,    // kernel idle, value: ticks to sleep
+		sleepEnd       // kernel back, to: thread to run
+	};
+
+	/*
+     * Event trace dump layout, little endian: one TraceFileHeader,
+     * nThreads TraceFileThread and nEvents TraceFileEvent, oldest first.
+     */
+
+#define ATOMICX_TRACE_MAGIC 0x52545841 // "AXTR"
+#define ATOMICX_TRACE_VERSION 1
+
+	struct TraceFileHeader
+	{
+		uint32_t nMagic;
+		uint32_t nVersion;
+		uint32_t nThreads;
+		uint32_t nEvents;
+		uint64_t nLost;
+	};
+
+	struct TraceFileThread
+	{
+		uint64_t nId;
+		char name[32];
+	};
+
+	struct TraceFileEvent
+	{
+		uint64_t nTick;
+		uint64_t nFrom;
+		uint64_t nTo;
+		uint64_t nValue;
+		uint8_t type;
+		uint8_t status;
+		uint8_t reserved[6];
+	};
+
 	class Thread;
 
 	/* *************************************************** *\
@@ -244,6 +645,12 @@ namespace atomicx
 		T *m_ptr;
 	};
 
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+	// The thread table keeps the order, no links in the thread itself
+	struct KNode
+	{
+	};
+#else
 	struct KNode
 	{
 	protected:
@@ -256,9 +663,160 @@ namespace atomicx
 			return pNext;
 		}
 	};
+#endif
 
 #define SYSTEM_CHANNEL 1
 
+#if defined(ATOMICX_MULTICORE) || defined(ATOMICX_OUTSIDE_NOTIFY)
+	/* *************************************************** *\
+        MPSC QUEUE CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Bounded lock-free queue, many producers and one consumer
+     *
+     * @tparam T    Type of the items, copied in and out
+     * @tparam N    Capacity in items
+     *
+     * @note    Push never blocks or allocates, it only spins on a CAS
+     *          while other producers race for the same slot.
+     */
+	template <typename T, size_t N>
+	class MpscQueue
+	{
+	public:
+		MpscQueue()
+		{
+			for (size_t nCount = 0; nCount < N; nCount++)
+			{
+				m_cells[nCount].nSequence.store(nCount, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+         * @brief Add an item, safe from any thread or signal handler
+         *
+         * @param item  Item to be copied in
+         *
+         * @return true if queued, false if the queue is full
+         */
+		bool Push(const T &item)
+		{
+			size_t nPos = m_nTail.load(std::memory_order_relaxed);
+			Cell *pCell;
+
+			while (true)
+			{
+				pCell = &m_cells[nPos % N];
+
+				size_t nSequence = pCell->nSequence.load(std::memory_order_acquire);
+				intptr_t nDiff   = (intptr_t)nSequence - (intptr_t)nPos;
+
+				if (nDiff == 0)
+				{
+					if (m_nTail.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (nDiff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					nPos = m_nTail.load(std::memory_order_relaxed);
+				}
+			}
+
+			pCell->item = item;
+			pCell->nSequence.store(nPos + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		/**
+         * @brief Take the oldest item, only the owner may call it
+         *
+         * @param item  Receives the item
+         *
+         * @return true if an item was taken, false if empty
+         */
+		bool Pop(T &item)
+		{
+			Cell &cell = m_cells[m_nHead % N];
+
+			if (cell.nSequence.load(std::memory_order_acquire) != m_nHead + 1)
+			{
+				return false;
+			}
+
+			item = cell.item;
+			cell.nSequence.store(m_nHead + N, std::memory_order_release);
+			m_nHead++;
+
+			return true;
+		}
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> nSequence;
+			T item;
+		};
+
+		Cell m_cells[N];
+		std::atomic<size_t> m_nTail{0};
+		size_t m_nHead = 0;
+	};
+
+	class Kernel;
+#endif
+
+// longjmp value telling Join the scheduler has already run
+#define JOIN_SCHEDULED 2
+
+	/* *************************************************** *\
+        WAIT LIST CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Intrusive FIFO of the threads blocked on the same wait queue
+     *
+     * @note    A thread can only be in one WaitList at time, the links are
+     *          kept inside the Thread itself, so no memory is allocated.
+     */
+	class WaitList
+	{
+	public:
+		/**
+         * @brief Append a thread to the end of the list
+         *
+         * @param thread    Thread to be appended, removed first from any list it is in
+         */
+		void Push(Thread &thread);
+
+		/**
+         * @brief Remove a thread from the list
+         *
+         * @param thread    Thread to be removed
+         */
+		void Remove(Thread &thread);
+
+		/**
+         * @brief Get the oldest thread in the list
+         *
+         * @return Thread*  The first thread, otherwise nullptr
+         */
+		Thread *GetFirst();
+
+		bool IsEmpty();
+
+	private:
+		Thread *m_pHead = nullptr;
+		Thread *m_pTail = nullptr;
+	};
+
 
 	/* *************************************************** *\
         THREAD CLASS
@@ -267,6 +825,8 @@ namespace atomicx
 	template <typename T>
 	class Iterator;
 
+	class Mutex;
+
 	class Thread : public KNode
 	{
 	private:
@@ -275,65 +835,395 @@ namespace atomicx
 
 		friend class Mutex;
 		friend class SmartMutex;
+		friend class Semaphore;
+		friend class ConditionVariable;
+		friend class Barrier;
+		friend class WaitList;
+
+		template <typename T, size_t N>
+		friend class Channel;
+
+		template <typename F>
+		friend class EventGroup;
+
+		friend class Task;
+		friend class Timer;
 
 		/* Kernel ------------------ */
-		static Thread *m_pBegin;
-		static Thread *m_pEnd;
-		static Thread *m_pCurrent;
+		static ATOMICX_KERNEL_LOCAL Thread *m_pBegin;
+		static ATOMICX_KERNEL_LOCAL Thread *m_pEnd;
+		static ATOMICX_KERNEL_LOCAL Thread *m_pCurrent;
 
-		static size_t m_nNodeCounter;
+		static ATOMICX_KERNEL_LOCAL size_t m_nNodeCounter;
 
-		static volatile uint8_t *m_pStartStack;
+		static ATOMICX_KERNEL_LOCAL volatile uint8_t *m_pStartStack;
 
-		static jmp_buf m_joinContext;
+		static ATOMICX_KERNEL_LOCAL jmp_buf m_joinContext;
 
 		static Thread *GetCyclicalNext();
 
+		/**
+         * @brief Next thread in attach order
+         *
+         * @param thread    Attached thread
+         *
+         * @return The thread after it, nullptr for the last one
+         */
+		static Thread *GetNextAttached(Thread &thread);
+
 		static void Scheduler();
 
-		/* ------------------------ */
+#if ATOMICX_STACK_CHECK != ATOMICX_STACK_CHECK_NONE
+		/**
+         * @brief Apply ATOMICX_STACK_CHECK to the current thread and run
+         *        the next one, never returns
+         */
+		static void Overflow();
+#endif
 
-		/* Kernel ------------------ */
+		/**
+         * @brief Take a thread out of the kernel for good, status halted
+         */
+		static void Halt(Thread &thread);
 
-		Status m_status = Status::starting;
+		/**
+         * @brief run() of the current thread returned, restart or end it as
+         *        OnExit says and run the next one, never returns
+         */
+		static void Finish();
 
-		// Thread context register buffer
-		jmp_buf m_context = {};
+		/**
+         * @brief Point m_pCurrent to the next thread to run, the list scan or
+         *        the heap, depending on ATOMICX_SCHEDULER
+         */
+		static void SelectNext();
 
-		volatile uint8_t *m_pEndStack = nullptr;
-        uint8_t m_priority{0};
+		/**
+         * @brief Jump to the thread picked by Scheduler, through Join
+         *        only if it still has to be started
+         */
+		static void Resume();
 
-        atomicx_time m_nice{0};
-        atomicx_time m_nextEvent{0};
-        int32_t m_late{0};
+		static bool IsScheduledBefore(Thread &thread, Thread &other);
 
-        size_t nStackSize{0};
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_EDF
+		static bool IsDeadlineBefore(Thread &thread, Thread &other);
+#endif
 
-		size_t m_nMaxStackSize;
+#ifdef ATOMICX_DEDICATED_STACK
+		static void Bootstrap();
+		static void Launch();
+#endif
 
-		volatile size_t &m_stack;
+#ifdef ATOMICX_EVENT_TRACE
+		struct TraceRecord
+		{
+			atomicx_time nTick;
+			Thread *pFrom;
+			Thread *pTo;
+			size_t nValue;
+			TraceType type;
+			Status status;
+		};
+
+		static ATOMICX_KERNEL_LOCAL TraceRecord m_traceRing[ATOMICX_EVENT_TRACE_SIZE];
+		static ATOMICX_KERNEL_LOCAL size_t m_nTraceCount;
+
+		static inline void RecordEvent(TraceType type, Thread *pFrom, Thread *pTo, Status status, size_t nValue)
+		{
+			TraceRecord &record = m_traceRing[m_nTraceCount++ % ATOMICX_EVENT_TRACE_SIZE];
+
+			record.nTick  = GetTick();
+			record.pFrom  = pFrom;
+			record.pTo    = pTo;
+			record.nValue = nValue;
+			record.type   = type;
+			record.status = status;
+		}
+#endif
 
-		/* ------------------------ */
+		/**
+         * @brief Nothing to run for nSleep ticks, SleepTick or, with
+         *        ATOMICX_REACTOR, wait for file descriptors meanwhile
+         */
+		static void Idle(atomicx_time nSleep);
 
-        enum class NotifyChennelType : uint16_t
-        {
-            KERNEL,
-            MUTEX,
-            USER
-        };
-        
-		/* Notify controller-------- */
-        void *m_pWaitEndPoint{nullptr};
-        
-        Message m_messagectl;
-        
-        NotifyChennelType m_msgChannel{NotifyChennelType::KERNEL};
+#ifdef ATOMICX_REACTOR
+		static ATOMICX_KERNEL_LOCAL int m_nEpoll;
+		static ATOMICX_KERNEL_LOCAL size_t m_nIoWaiters;
+		static ATOMICX_KERNEL_LOCAL atomicx_time m_nLastPoll;
 
-        union
-        {
-            bool noTimout : 1;
+		// Threads in WaitReadable or WaitWritable, woken by PollIO only
+		static ATOMICX_KERNEL_LOCAL WaitList m_ioWaitList;
+
+		/**
+         * @brief Wake the threads whose file descriptor is ready
+         *
+         * @param nSleep    Ticks to wait for one, (atomicx_time)-1 waits forever
+         *
+         * @return size_t Number of threads woken
+         */
+		static size_t PollIO(atomicx_time nSleep);
+
+		bool WaitIO(int nFd, uint32_t nEvents, Timeout &tm);
+#endif
+
+#ifdef ATOMICX_OUTSIDE_NOTIFY
+		// Written by NotifyFromOutside to end an idle wait, -1 if not open
+		static std::atomic<int> m_nWakeFd;
+
+		static void OpenWakeFd();
+
+#ifdef ATOMICX_OUTSIDE_WAKE
+		static void ClearWakeFd();
+#endif
+
+		/**
+         * @brief Idle for nSleep ticks, or till NotifyFromOutside writes the wake fd
+         */
+		static void WaitOutside(atomicx_time nSleep);
+
+		static bool PostOutside(void *pEndPoint, Message msg, atomicx::Notify howMany);
+
+#ifndef ATOMICX_MULTICORE
+		struct OutsideNotify
+		{
+			void *pEndPoint;
+			Message msg;
+			atomicx::Notify howMany;
+		};
+
+		static MpscQueue<OutsideNotify, ATOMICX_OUTSIDE_QUEUE_SIZE> m_outsideQueue;
+
+		/**
+         * @brief Deliver the notifications queued by NotifyFromOutside
+         */
+		static void DrainOutside();
+#endif
+#endif
+
+#ifdef ATOMICX_MULTICORE
+		friend class Kernel;
+
+		static ATOMICX_KERNEL_LOCAL Kernel m_kernel;
+
+		// Threads alive in all instances, Join returns when it drops to 0
+		static std::atomic<size_t> m_nTotalThreads;
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+		static ATOMICX_KERNEL_LOCAL Thread *m_schedHeap[ATOMICX_SCHED_HEAP_SIZE];
+		static ATOMICX_KERNEL_LOCAL size_t m_nSchedHeapSize;
+		static ATOMICX_KERNEL_LOCAL size_t m_nSchedCounter;
+
+		static bool IsHeapBefore(Thread &thread, Thread &other);
+		static void SchedHeapSwap(size_t nIndexA, size_t nIndexB);
+		static void SchedHeapUp(size_t nIndex);
+		static void SchedHeapDown(size_t nIndex);
+		static Thread *SchedHeapNext();
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+		/*
+         * Attached threads in attach order, m_nNodeCounter entries used, with
+         * their scheduling key mirrored by UpdateSchedule in parallel arrays;
+         * the rank is the priority, or -1 for a thread waiting without timeout.
+         */
+		static ATOMICX_KERNEL_LOCAL Thread *m_schedThread[ATOMICX_MAX_THREADS];
+		static ATOMICX_KERNEL_LOCAL atomicx_time m_schedNextEvent[ATOMICX_MAX_THREADS];
+		static ATOMICX_KERNEL_LOCAL int32_t m_schedRank[ATOMICX_MAX_THREADS];
+
+#ifdef ATOMICX_SCHED_SIMD
+		static void SchedTableFind(size_t nBegin, size_t nEnd, atomicx_time nRef, int32_t &nBestRel, int32_t &nBestRank, size_t &nBest);
+#endif
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+		enum class SchedState : uint8_t
+		{
+			detached,
+			parked,
+			delayed,
+			ready
+		};
+
+		static const size_t PRIO_WORDS = (ATOMICX_PRIO_LEVELS + 31) / 32;
+
+		// Ready threads, per level in nextEvent order, bit n set while level n is not empty
+		static ATOMICX_KERNEL_LOCAL Thread *m_readyHead[ATOMICX_PRIO_LEVELS];
+		static ATOMICX_KERNEL_LOCAL Thread *m_readyTail[ATOMICX_PRIO_LEVELS];
+		static ATOMICX_KERNEL_LOCAL uint32_t m_readyBitmap[PRIO_WORDS];
+		static ATOMICX_KERNEL_LOCAL uint32_t m_readySummary;
+
+		// Threads not due yet, min-heap on nextEvent
+		static ATOMICX_KERNEL_LOCAL Thread *m_delayHeap[ATOMICX_MAX_THREADS];
+		static ATOMICX_KERNEL_LOCAL size_t m_nDelayHeapSize;
+
+		// Tick of the last selection, threads due by then go straight to their ready list
+		static ATOMICX_KERNEL_LOCAL atomicx_time m_nSchedTick;
+
+		static void SchedRequeue(Thread &thread);
+		static void SchedUnlink(Thread &thread);
+		static void SchedReadyInsert(Thread &thread);
+		static void SchedDelaySwap(size_t nIndexA, size_t nIndexB);
+		static void SchedDelayUp(size_t nIndex);
+		static void SchedDelayDown(size_t nIndex);
+#endif
+
+		/* ------------------------ */
+
+		/* Kernel ------------------ */
+
+		Status m_status = Status::starting;
+
+		// Thread context register buffer
+		jmp_buf m_context = {};
+
+		volatile uint8_t *m_pEndStack = nullptr;
+        uint8_t m_priority{0};
+        uint8_t m_basePriority{0};
+
+        // Exclusive Mutex locks held, linked through Mutex::m_pNextHeld, the
+        // inherited priority is recomputed from their waiters
+        Mutex *m_pLocksHeld{nullptr};
+
+        // Shared Mutex locks held
+        uint8_t m_nSharedHeld{0};
+
+        atomicx_time m_nice{0};
+        atomicx_time m_nextEvent{0};
+        int32_t m_late{0};
+
+#ifdef ATOMICX_ACCOUNTING
+        atomicx_time m_nResumeTick{0};
+        atomicx_time m_nRunTicks{0};
+
+        size_t m_nYields{0};
+        size_t m_nTimeouts{0};
+        size_t m_nWakeUpsSent{0};
+        size_t m_nWakeUpsReceived{0};
+        size_t m_nPeakStackSize{0};
+
+        static ATOMICX_KERNEL_LOCAL atomicx_time m_nIdleTicks;
+#endif
+
+        size_t nStackSize{0};
+
+		size_t m_nMaxStackSize;
+
+		volatile size_t &m_stack;
+
+		// Stackless Task, run() is called right on the Join stack
+		bool m_bTask{false};
+
+#ifdef ATOMICX_MULTICORE
+		// Never handed to another instance
+		bool m_bPinned{false};
+#endif
+
+		// What a Task's m_stack refers to, it is never used
+		static volatile size_t m_nNoStack;
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+		// Stamped on every re-key, orders threads whose whole key is equal
+		size_t m_nSchedSeq{0};
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP || ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE || ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+		size_t m_nSchedIndex{0};
+#endif
+
+#ifdef ATOMICX_PERIODIC
+		atomicx_time m_nPeriod{0};
+		atomicx_time m_nRelativeDeadline{0};
+		atomicx_time m_nRelease{0};
+		atomicx_time m_nDeadline{0};
+
+		size_t m_nDeadlineMisses{0};
+		int32_t m_nWorstLate{0};
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+		Thread *m_pReadyPrev{nullptr};
+		Thread *m_pReadyNext{nullptr};
+
+		SchedState m_schedState{SchedState::detached};
+
+		// Level whose ready list holds the thread, kept apart as m_priority may change first
+		uint8_t m_nReadyLevel{0};
+#endif
+
+		/**
+         * @brief Must be called every time m_nextEvent, m_priority or
+         *        m_flags.noTimout changes, so the scheduler backend can
+         *        re-key the thread
+         */
+		void UpdateSchedule()
+		{
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+			if (m_nSchedIndex < m_nSchedHeapSize && m_schedHeap[m_nSchedIndex] == this)
+			{
+				m_nSchedSeq = m_nSchedCounter++;
+
+				SchedHeapUp(m_nSchedIndex);
+				SchedHeapDown(m_nSchedIndex);
+			}
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+			if (m_nSchedIndex < m_nNodeCounter && m_schedThread[m_nSchedIndex] == this)
+			{
+				m_schedNextEvent[m_nSchedIndex] = m_nextEvent;
+				m_schedRank[m_nSchedIndex]      = m_flags.noTimout ? -1 : m_priority;
+			}
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+			if (m_schedState != SchedState::detached)
+			{
+				SchedRequeue(*this);
+			}
+#endif
+		}
+
+		/* ------------------------ */
+
+        enum class NotifyChennelType : uint16_t
+        {
+            KERNEL,
+            MUTEX,
+            CHANNEL,
+            SEMAPHORE,
+            CONDITION,
+            BARRIER,
+            EVENT,
+            USER
+        };
+        
+		/* Notify controller-------- */
+        static ATOMICX_KERNEL_LOCAL WaitList m_waitBuckets[ATOMICX_WAIT_BUCKETS];
+
+        static WaitList &GetWaitBucket(NotifyChennelType channel, void *pEndPoint)
+        {
+            return m_waitBuckets[(((size_t)pEndPoint >> 2) ^ (size_t)channel) % ATOMICX_WAIT_BUCKETS];
+        }
+
+        WaitList *m_pWaitList{nullptr};
+        Thread *m_pWaitPrev{nullptr};
+        Thread *m_pWaitNext{nullptr};
+
+        void *m_pWaitEndPoint{nullptr};
+        
+        Message m_messagectl;
+        
+        NotifyChennelType m_msgChannel{NotifyChennelType::KERNEL};
+
+        union
+        {
+            struct
+            {
+                bool noTimout : 1;
+                bool eventAll : 1;   // EventGroup waiter needs all the bits
+                bool eventClear : 1; // EventGroup waiter consumes the bits
+            };
             uint8_t nValue;
-        } m_flags{0};
+        } m_flags{};
         
 		Thread() = delete;
         /* ------------------------ */
@@ -342,41 +1232,193 @@ namespace atomicx
 
         virtual void run(void) = 0;
 
+		/**
+         * @brief Called on the Join stack once run() returns
+         *
+         * @return true (default) to run it again from the start, false to end
+         *         the thread: it is detached and halted till Start
+         */
+		virtual bool OnExit();
+
+		/**
+         * @brief Attach a halted thread again, run() starts from the beginning
+         *
+         * @return false if the thread is not halted
+         */
+		bool Start();
+
+		/**
+         * @brief End another thread, as if its run() had returned with OnExit false
+         *
+         * @return false if it is the calling thread or already halted
+         *
+         * @note    Nothing is unwound, it must not hold any Mutex
+         */
+		bool Stop();
+
 		static bool AttachThread(Thread &thread);
 
+		/**
+         * @brief Attach a newly constructed thread, halts it if the scheduler is full
+         *
+         * @note    The caller sees the failure as GetStatus() == Status::halted
+         */
+		void AttachNew();
+
 		static bool DetachThread(Thread &thread);
 
 		void SetPriority(uint8_t value);
 
+		void SetNice(atomicx_time nNice);
+
+#ifdef ATOMICX_PERIODIC
+		/**
+         * @brief Make the thread periodic, its current job is released now
+         *
+         * @param nPeriod   Ticks between releases, 0 makes it aperiodic again
+         * @param nDeadline Ticks from release the job must end within, 0 for nPeriod
+         */
+		void SetPeriod(atomicx_time nPeriod, atomicx_time nDeadline = 0);
+#endif
+
 		template <size_t N>
 		Thread(atomicx_time nNice, volatile size_t (&stack)[N])
 		    : m_nice(nNice)
+		    , m_nextEvent(GetTick())
 		    , m_nMaxStackSize(N * sizeof(size_t))
 		    , m_stack(stack[0])
 		{
-			AttachThread(*this);
+			static_assert(N * sizeof(size_t) >= ATOMICX_MIN_STACK_SIZE, "stack[N] smaller than ATOMICX_MIN_STACK_SIZE");
+
+#ifdef ATOMICX_STACK_WATERMARK
+			memset((void *)stack, ATOMICX_STACK_PATTERN, sizeof(stack));
+#elif defined(ATOMICX_DEDICATED_STACK)
+			// The stack grows down towards it
+			stack[0] = ATOMICX_STACK_CANARY;
+#endif
+			AttachNew();
 		}
 
-        inline size_t SafeNotify(Status status, NotifyChennelType channel, void* pEndPoit, Message msg)
+		/**
+         * @brief Construct a stackless thread, only used by Task
+         */
+		explicit Thread(atomicx_time nNice);
+
+        /**
+         * @brief Take the thread out of its wait list and make it ready to run now
+         *
+         * @param nMessage  Message delivered to the woken thread
+         */
+        inline void WakeUp(size_t nMessage)
+        {
+            if (m_pWaitList != nullptr)
+            {
+                m_pWaitList->Remove(*this);
+            }
+
+            TRACE_EVENT(notify, m_pCurrent, this, m_status, nMessage);
+
+#ifdef ATOMICX_ACCOUNTING
+            if (m_pCurrent != nullptr)
+            {
+                m_pCurrent->m_nWakeUpsSent++;
+            }
+
+            m_nWakeUpsReceived++;
+#endif
+
+            m_messagectl.message = nMessage;
+            m_status = Status::now;
+            m_nextEvent = GetTick();
+            m_flags.noTimout = false;
+            UpdateSchedule();
+        }
+
+        /**
+         * @brief Park the current thread in a wait list till WakeUp or timeout
+         *
+         * @param waitList  Wait list owned by the synchronisation object
+         * @param channel   Notify channel type
+         * @param pEndPoint Object the thread is blocked on
+         * @param nType     Request type, kept in m_messagectl.type for the waker
+         * @param tm        Timeout, if 0 waits forever
+         * @param st        Status to show while blocked
+         *
+         * @return true if woken up, false on timeout
+         */
+        static bool SafeBlock(WaitList& waitList, NotifyChennelType channel, void* pEndPoint, size_t nType, Timeout& tm, Status st);
+
+        /**
+         * @brief Keep the current thread on this instance, called by the
+         *        objects that are not multicore-safe on every use
+         */
+        static void PinCurrent()
+        {
+#ifdef ATOMICX_MULTICORE
+            if (m_pCurrent != nullptr)
+            {
+                m_pCurrent->m_bPinned = true;
+            }
+#endif
+        }
+
+#ifdef ATOMICX_MULTICORE
+        /**
+         * @brief Queue a notification to all the other kernel instances
+         *
+         * @return size_t Number of instances it was queued to
+         */
+        static size_t ForwardNotify(NotifyChennelType channel, void* pEndPoint, Message msg, Notify howMany);
+#endif
+
+        /**
+         * @brief Wake the threads waiting on the endpoint without blocking, for
+         *        code that must not Yield (Task, Timer callbacks)
+         *
+         * @return size_t Number of threads woken (or instances it was queued to)
+         */
+        static size_t PostNotify(NotifyChennelType channel, void* pEndPoint, Message msg, atomicx::Notify howMany);
+
+        /**
+         * @brief Wake the threads waiting on the endpoint, oldest first, in one pass
+         *
+         * @param status    Status the waiters must be in (wait or syncWait)
+         * @param channel   Notify channel type
+         * @param pEndPoit  Endpoint
+         * @param msg       Message to deliver, msg.type must match the waiter's
+         * @param howMany   Notify::one stops at the first waiter woken
+         *
+         * @return size_t Number of threads woken
+         */
+        static inline size_t SafeNotify(Status status, NotifyChennelType channel, void* pEndPoit, Message msg, Notify howMany)
         {
             size_t nNotified = 0;
             
             NOTRACE(WAIT, "LOOKING: EP:" << pEndPoit << ", Status:" << GetStatusName(status) << ", type:" << msg.type << ", channel:" << (uint16_t) channel);
             
-            for (auto& th : *this)
+            WaitList& waitList = GetWaitBucket(channel, pEndPoit);
+            Thread* pNext = waitList.GetFirst();
+
+            while (pNext != nullptr)
             {
+                Thread& th = *pNext;
+                pNext = th.m_pWaitNext;
+
                 NOTRACE(WAIT, "TRYING: " << &th << ", EP:" << th.m_pWaitEndPoint << ", Status:" << GetStatusName(th.m_status) << ", type:" << th.m_messagectl.type << ", channel:" << (uint16_t) th.m_msgChannel);
                 
                 if (th.m_status == status && th.m_msgChannel == channel && th.m_pWaitEndPoint == pEndPoit)
                 {
                     if (th.m_messagectl.type == msg.type)
                     {
-                        th.m_messagectl.message = msg.message;
-                        th.m_status = Status::now;
-                        th.m_nextEvent = GetTick();
+                        th.WakeUp(msg.message);
                         nNotified++;
                         
                         TRACE(WAIT, "EP:" << &th << ", type:" << th.m_messagectl.type << ", msg:" << th.m_messagectl.message);
+
+                        if (howMany == atomicx::Notify::one)
+                        {
+                            break;
+                        }
                     }
                 }
             }
@@ -392,15 +1434,19 @@ namespace atomicx
             m_pWaitEndPoint = endPoint;
             m_messagectl.type = nType;
             m_flags.noTimout = !tm.CanTimeout();
+
+            GetWaitBucket(channel, endPoint).Push(*this);
         }
         
         bool GenericWait(NotifyChennelType channel, void* endPoint, size_t nType, size_t& nMessage, Timeout tm)
         {
-            SafeNotify(Status::syncWait, channel, endPoint, {.type = nType, .message=0});
-            Yield(0, Status::now);
-            
+            // Queue first, so a notifier woken here always finds this thread waiting
             SafeWait(channel, endPoint, nType, tm);
-            
+
+            SafeNotify(Status::syncWait, channel, endPoint, {.message = 0, .type = nType}, atomicx::Notify::one);
+
+            TRACE_EVENT(wait, this, nullptr, Status::wait, endPoint);
+
             Yield(tm.GetRemaining(), Status::wait);
             
             if (m_status != Status::timeout)
@@ -416,10 +1462,23 @@ namespace atomicx
         inline size_t GenericNotify(NotifyChennelType channel, void* endPoint, Message msg, Timeout tm, Notify howMany)
         {
             size_t nNotified = 0;
+
+#ifdef ATOMICX_MULTICORE
+            // Nobody waits here, hand it to the other instances without the syncWait handshake
+            if ((nNotified = SafeNotify(Status::wait, channel, endPoint, msg, howMany)) > 0 || (nNotified = ForwardNotify(channel, endPoint, msg, howMany)) > 0)
+            {
+                Yield(0, Status::now);
+
+                return nNotified;
+            }
+#endif
             
-            while ((nNotified = SafeNotify(Status::wait, channel, endPoint, msg) == 0 && tm.GetRemaining()))
+            while ((nNotified = SafeNotify(Status::wait, channel, endPoint, msg, howMany)) == 0 && tm.GetRemaining())
             {
                 SafeWait(channel, endPoint, msg.type, tm);
+
+                TRACE_EVENT(wait, this, nullptr, Status::syncWait, endPoint);
+
                 Yield(tm.GetRemaining(), Status::syncWait);
                 
                 if (m_status == Status::timeout)
@@ -446,6 +1505,26 @@ namespace atomicx
             return GenericWait(NotifyChennelType::USER, (void*)&endPoint, nType, nMessage, tm);
         }
 
+#ifdef ATOMICX_REACTOR
+        /**
+         * @brief Block till nFd can be read without blocking
+         *
+         * @param nFd   File descriptor, usually O_NONBLOCK
+         * @param tm    Timeout, if 0 waits forever
+         *
+         * @return true if ready (error and hang up included), false on timeout or
+         *         if nFd can not be watched
+         *
+         * @note Only one thread at a time may wait on the same nFd
+         */
+        bool WaitReadable(int nFd, Timeout tm = Timeout());
+
+        /**
+         * @brief Block till nFd can be written without blocking, same as WaitReadable
+         */
+        bool WaitWritable(int nFd, Timeout tm = Timeout());
+#endif
+
 	public:
 		virtual const char *GetName() = 0;
 
@@ -455,10 +1534,25 @@ namespace atomicx
 
 		size_t GetMaxStackSize();
 
+#ifdef ATOMICX_STACK_WATERMARK
+		/**
+         * @brief Most bytes of stack[N] ever used, compare with GetMaxStackSize
+         *        to know how close the thread came to overflowing
+         */
+		size_t GetStackWatermark();
+#endif
+
 		Iterator<Thread> begin();
 
 		Iterator<Thread> end();
 
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE
+		/**
+         * @brief Iterator movement, next thread in the table
+         */
+		Thread *operator++();
+#endif
+
 		/*
          * ATTENTION: GetTick and SleepTick MUST be ported from user
          *
@@ -486,21 +1580,1200 @@ namespace atomicx
          */
 		static void SleepTick(atomicx_time nSleep);
 
+#if ATOMICX_STACK_CHECK == ATOMICX_STACK_CHECK_HOOK
+		/**
+         * @brief Implement to be told about a stack overflow, with
+         *        ATOMICX_STACK_CHECK_HOOK, the thread is halted on return
+         *
+         * @param thread    Thread whose stack outgrew its stack[N]
+         */
+		static void StackOverflow(Thread &thread);
+#endif
+
 		static bool Join();
 
 		static bool Yield(atomicx_time tm = 0, Status st = Status::sleep);
 
+#ifdef ATOMICX_PERIODIC
+		/**
+         * @brief End the current job of a periodic thread and sleep till its
+         *        next release
+         *
+         * @return false if the current thread is not periodic
+         */
+		static bool WaitNextPeriod();
+#endif
+
 		size_t GetThreadCount();
 
 		Status GetStatus();
 
 		atomicx_time GetNice();
 
+		/**
+         * @brief Effective priority, includes any priority lent by a Mutex waiter
+         */
+		uint8_t GetPriority();
+
 		static Thread *GetCurrent();
 
 		atomicx_time GetNextEvent();
 
 		int32_t GetLate();
+
+#ifdef ATOMICX_ACCOUNTING
+		/**
+         * @brief Ticks spent running, from being scheduled till its Yield
+         */
+		atomicx_time GetRunTicks();
+
+		/**
+         * @brief How many times it gave the CPU away through Yield, blocking calls included
+         */
+		size_t GetYieldCount();
+
+		/**
+         * @brief How many times it was resumed because a wait or lock timed out
+         */
+		size_t GetTimeoutCount();
+
+		/**
+         * @brief How many threads it woke up, through Notify, Mutex or Channel
+         */
+		size_t GetWakeUpsSent();
+
+		/**
+         * @brief How many times it was woken up by another thread
+         */
+		size_t GetWakeUpsReceived();
+
+		/**
+         * @brief Largest stack in use seen at a context switch, to size stack[N]
+         */
+		size_t GetPeakStackSize();
+
+		/**
+         * @brief Ticks the kernel spent sleeping with nothing to run
+         */
+		static atomicx_time GetIdleTicks();
+#endif
+
+#ifdef ATOMICX_PERIODIC
+		atomicx_time GetPeriod();
+
+		/**
+         * @brief Tick the current job must end by
+         */
+		atomicx_time GetDeadline();
+
+		/**
+         * @brief Jobs that ended past their deadline or were dropped
+         */
+		size_t GetDeadlineMisses();
+
+		/**
+         * @brief Worst GetLate seen at a release, how many ticks a job started late
+         */
+		int32_t GetWorstLate();
+#endif
+
+#ifdef ATOMICX_EVENT_TRACE
+		/**
+         * @brief Write the recorded events out, oldest first, in the
+         *        TraceFileHeader layout
+         *
+         * @param pWriter   Called for every piece of the dump, ex fwrite to a file
+         * @param pContext  Passed along to pWriter
+         */
+		static void DumpTrace(void (*pWriter)(const void *pData, size_t nSize, void *pContext), void *pContext);
+
+		/**
+         * @brief Drop all the recorded events
+         */
+		static void ClearTrace();
+#endif
+
+#ifdef ATOMICX_OUTSIDE_NOTIFY
+		/**
+         * @brief Notify threads in Wait from outside the kernel: other OS threads,
+         *        signal handlers (async-signal-safe) or ISRs
+         *
+         * @param endPoint  Same endpoint the threads Wait on
+         * @param msg       Message to deliver, msg.type must match the waiter's
+         * @param howMany   Notify::one wakes only the oldest waiter
+         *
+         * @return true if queued, false if ATOMICX_OUTSIDE_QUEUE_SIZE is full
+         *
+         * @note    Delivered at the next scheduling, it is lost if nobody waits
+         *          by then, there is no syncWait handshake. With ATOMICX_MULTICORE
+         *          every instance gets it.
+         */
+		template <typename T>
+		static bool NotifyFromOutside(T &endPoint, Message msg, atomicx::Notify howMany = atomicx::Notify::one)
+		{
+			return PostOutside((void *)&endPoint, msg, howMany);
+		}
+#endif
+
+#ifdef ATOMICX_MULTICORE
+		/**
+         * @brief Get the kernel instance of the calling OS thread
+         */
+		static Kernel &GetKernel();
+
+		/**
+         * @brief Keep the thread on its instance, or let it migrate again once
+         *        it is done with the objects that pinned it
+         */
+		void SetPinned(bool bPinned);
+
+		bool IsPinned();
+#endif
+	};
+
+	/* *************************************************** *\
+        TASK CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Stackless thread, scheduled with the same nextEvent and priority
+     *        rules, for small state machines (sensors, protocol handlers)
+     *
+     * @note    Step runs to completion right on the Join stack, so a Task has
+     *          no stack[N] and switching to or from it copies nothing. It must
+     *          never block: no Yield, Wait, Lock or Notify with timeout, it
+     *          returns and tells when to run again instead. Keep the state
+     *          it needs across steps in members.
+     */
+	class Task : public Thread
+	{
+	protected:
+		/**
+         * @brief Construct a new Task
+         *
+         * @param nNice     Ticks between two steps, if Step does not ask otherwise
+         */
+		explicit Task(atomicx_time nNice);
+
+		/**
+         * @brief One step of the task, GetStatus tells why it runs:
+         *        starting, sleep, now (notified) or timeout
+         */
+		virtual void Step() = 0;
+
+		/**
+         * @brief Run the next step in tm ticks instead of nice
+         */
+		void Sleep(atomicx_time tm);
+
+		/**
+         * @brief Run the next step when endPoint is notified with nType, or
+         *        once tm expires (status timeout)
+         *
+         * @param endPoint  Endpoint, same as Thread::Wait
+         * @param nType     Notification type
+         * @param tm        Timeout, if 0 waits forever
+         */
+		template <typename T>
+		void Await(T &endPoint, size_t nType, Timeout tm = Timeout())
+		{
+			AwaitEndPoint((void *)&endPoint, nType, tm);
+		}
+
+		/**
+         * @brief Wake the threads and tasks waiting on endPoint, never blocks
+         *
+         * @return size_t Number of threads woken (or instances it was queued to)
+         */
+		template <typename T>
+		size_t Notify(T &endPoint, Message msg, atomicx::Notify howMany = atomicx::Notify::one)
+		{
+			return PostNotify(NotifyChennelType::USER, (void *)&endPoint, msg, howMany);
+		}
+
+		/**
+         * @brief Message of the notification that woke this step
+         */
+		size_t GetMessage();
+
+		// Would block on a stack the Task does not have
+		static bool Yield(atomicx_time tm = 0, Status st = Status::sleep) = delete;
+
+#ifdef ATOMICX_PERIODIC
+		static bool WaitNextPeriod() = delete;
+#endif
+
+		template <typename T>
+		size_t Wait(T &endPoint, size_t nType, size_t &nMessage, Timeout tm) = delete;
+
+	private:
+		void run() final;
+
+		void AwaitEndPoint(void *pEndPoint, size_t nType, Timeout &tm);
+
+		// Step chose its next run, Sleep or Await
+		bool m_bScheduled{false};
+	};
+
+	/* *************************************************** *\
+        THREAD POOL CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Fixed set of N threads, StackWords stack each, that run
+     *        callables on demand without new or delete
+     *
+     * @note    A slot is taken by Spawn and given back as soon as the
+     *          callable returns, its thread is then halted (see
+     *          Thread::OnExit). The pool must outlive its threads.
+     */
+	template <size_t N, size_t StackWords>
+	class ThreadPool
+	{
+	public:
+		/**
+         * @brief Run a callable in a thread of the pool
+         *
+         * @param callable  Called once with no arguments, copied into the slot
+         * @param nNice     Nice of the thread running it
+         *
+         * @return true if started, false if every slot is busy
+         */
+		template <typename F>
+		bool Spawn(const F &callable, atomicx_time nNice = 0)
+		{
+			static_assert(sizeof(F) <= ATOMICX_POOL_CALLABLE_SIZE, "callable larger than ATOMICX_POOL_CALLABLE_SIZE");
+
+			for (Slot &slot : m_slots)
+			{
+				if (slot.GetStatus() == Status::halted)
+				{
+					return slot.Launch(callable, nNice);
+				}
+			}
+
+			return false;
+		}
+
+		/**
+         * @brief How many more callables Spawn can take now
+         */
+		size_t GetFreeCount()
+		{
+			size_t nFree = 0;
+
+			for (Slot &slot : m_slots)
+			{
+				nFree += slot.GetStatus() == Status::halted;
+			}
+
+			return nFree;
+		}
+
+	private:
+		class Slot : public Thread
+		{
+		public:
+			Slot()
+			    : Thread(0, nStack)
+			{
+				// Attached by Thread, it waits halted for Spawn
+				Stop();
+			}
+
+			virtual ~Slot()
+			{
+				if (m_pDestroy != nullptr)
+				{
+					m_pDestroy(m_callable);
+				}
+			}
+
+			template <typename F>
+			bool Launch(const F &callable, atomicx_time nNice)
+			{
+				static_assert(alignof(F) <= 2 * sizeof(void *), "callable alignment not supported");
+
+				new ((void *)m_callable) F(callable);
+
+				m_pInvoke  = [](void *pCallable) { (*(F *)pCallable)(); };
+				m_pDestroy = [](void *pCallable) { ((F *)pCallable)->~F(); };
+
+				SetNice(nNice);
+
+				if (!Start())
+				{
+					OnExit();
+
+					return false;
+				}
+
+				return true;
+			}
+
+			virtual const char *GetName() final
+			{
+				return "ThreadPool";
+			}
+
+		protected:
+			virtual void run() final
+			{
+				m_pInvoke(m_callable);
+			}
+
+			virtual bool OnExit() final
+			{
+				m_pDestroy(m_callable);
+				m_pDestroy = nullptr;
+
+				return false;
+			}
+
+		private:
+			volatile size_t nStack[StackWords];
+
+			alignas(2 * sizeof(void *)) uint8_t m_callable[ATOMICX_POOL_CALLABLE_SIZE];
+
+			void (*m_pInvoke)(void *pCallable)  = nullptr;
+			void (*m_pDestroy)(void *pCallable) = nullptr;
+		};
+
+		Slot m_slots[N];
+	};
+
+#ifdef ATOMICX_TIMERS
+	/* *************************************************** *\
+        TIMER CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief One-shot or periodic callback, called by the scheduler once its
+     *        deadline is reached, before any thread due at the same tick
+     *
+     * @note    The callback runs in the scheduler, GetCurrent is nullptr: it
+     *          must not Yield or block, use Timer::Notify to wake threads up.
+     *          A timer belongs to the kernel instance that started it.
+     */
+	class Timer
+	{
+	public:
+		typedef void (*Callback)(Timer &timer, void *pContext);
+
+		/**
+         * @brief Construct a new stopped Timer
+         *
+         * @param pCallback Called on every expiry
+         * @param pContext  Passed along to pCallback
+         */
+		Timer(Callback pCallback, void *pContext = nullptr);
+
+		~Timer();
+
+		/**
+         * @brief (Re)start the timer nDelay ticks from now
+         *
+         * @param nDelay    Ticks till the first expiry
+         * @param nPeriod   Ticks between expiries, 0 for one-shot
+         *
+         * @return false if ATOMICX_TIMER_HEAP_SIZE timers are already running
+         */
+		bool Start(atomicx_time nDelay, atomicx_time nPeriod = 0);
+
+		/**
+         * @brief (Re)start the timer at an absolute tick, see Start
+         */
+		bool StartAt(atomicx_time nDeadline, atomicx_time nPeriod = 0);
+
+		/**
+         * @brief Stop the timer, safe from its own callback
+         *
+         * @return false if it was not running
+         */
+		bool Stop();
+
+		bool IsActive();
+
+		/**
+         * @brief Tick of the next expiry
+         */
+		atomicx_time GetDeadline();
+
+		atomicx_time GetPeriod();
+
+		/**
+         * @brief Periods skipped because the callback ran more than a period late
+         */
+		size_t GetOverruns();
+
+		/**
+         * @brief Wake the threads waiting on endPoint, never blocks
+         *
+         * @return size_t Number of threads woken (or instances it was queued to)
+         */
+		template <typename T>
+		static size_t Notify(T &endPoint, Message msg, atomicx::Notify howMany = atomicx::Notify::one)
+		{
+			return Thread::PostNotify(Thread::NotifyChennelType::USER, (void *)&endPoint, msg, howMany);
+		}
+
+	private:
+		friend class Thread;
+
+		/**
+         * @brief Call the callbacks due, from the scheduler
+         *
+         * @param nSleep    Ticks the scheduler would sleep
+         *
+         * @return atomicx_time nSleep, shortened to the next deadline
+         */
+		static atomicx_time Expire(atomicx_time nSleep);
+
+		static void HeapUp(size_t nIndex);
+		static void HeapDown(size_t nIndex);
+		static void HeapSwap(size_t nIndex, size_t nOther);
+
+		void Remove();
+
+		Callback m_pCallback;
+		void *m_pContext;
+
+		atomicx_time m_nDeadline{0};
+		atomicx_time m_nPeriod{0};
+
+		size_t m_nOverruns{0};
+		size_t m_nHeapIndex{0};
+
+		static ATOMICX_KERNEL_LOCAL Timer *m_heap[ATOMICX_TIMER_HEAP_SIZE];
+		static ATOMICX_KERNEL_LOCAL size_t m_nCount;
+	};
+#endif
+
+#ifdef ATOMICX_MULTICORE
+	/* *************************************************** *\
+        KERNEL CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Kernel instance, one for each OS thread running Thread::Join
+     *
+     * @note    Run queue, wait queues and the current thread are thread_local
+     *          members of Thread, this object only holds what the other
+     *          instances are allowed to touch: the inbox and the steal request.
+     */
+	class Kernel
+	{
+	public:
+		/**
+         * @brief Get how many threads this instance is running
+         */
+		size_t GetThreadCount();
+
+		/**
+         * @brief Get how many threads this instance took from the others
+         */
+		size_t GetStolenCount();
+
+	private:
+		friend class Thread;
+
+		enum class Request : uint8_t
+		{
+			migrate,
+			notify
+		};
+
+		struct Envelope
+		{
+			Request request;
+			Kernel *pFrom;
+			Thread *pThread;
+			Thread::NotifyChennelType channel;
+			void *pEndPoint;
+			Message msg;
+			Notify howMany;
+		};
+
+		/**
+         * @brief Make the instance visible to the others, once per OS thread
+         */
+		void Register();
+
+		/**
+         * @brief Attach the threads and deliver the notifications sent by the others
+         */
+		void Drain();
+
+		/**
+         * @brief Ask the busiest instance to hand over one of its ready threads
+         */
+		void RequestSteal();
+
+		/**
+         * @brief Hand a ready thread to the instance asking for one, if any
+         */
+		void Donate();
+
+		/**
+         * @brief Stop receiving from the other instances, when Join returns
+         */
+		void Unregister();
+
+		MpscQueue<Envelope, ATOMICX_KERNEL_INBOX_SIZE> m_inbox;
+
+		std::atomic<size_t> m_nThreads{0};
+		std::atomic<Kernel *> m_pThief{nullptr};
+
+		size_t m_nStolen = 0;
+		size_t m_nIndex  = ATOMICX_MAX_KERNELS;
+
+		static std::atomic<Kernel *> m_kernels[ATOMICX_MAX_KERNELS];
+		static std::atomic<size_t> m_nKernels;
+	};
+#endif
+
+	/* *************************************************** *\
+        MUTEX CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Reader/writer lock with direct ownership handoff
+     *
+     * @note    Waiters are served in FIFO order, on release the lock is given
+     *          straight to the next waiter(s) instead of waking every contender.
+     *          Writers have preference, new shared locks are not granted while
+     *          a writer is waiting.
+     */
+	class Mutex
+	{
+	public:
+		/**
+         * @brief Acquire the exclusive lock
+         *
+         * @param tm    Timeout, if 0 waits forever
+         *
+         * @return true if the lock was acquired, false on timeout
+         */
+		bool Lock(Timeout tm = Timeout());
+
+		/**
+         * @brief Release the exclusive lock, handing it to the next waiter
+         */
+		void Unlock();
+
+		/**
+         * @brief Acquire a shared lock
+         *
+         * @param tm    Timeout, if 0 waits forever
+         *
+         * @return true if the lock was acquired, false on timeout
+         */
+		bool SharedLock(Timeout tm = Timeout());
+
+		/**
+         * @brief Release a shared lock, handing the mutex to a writer if it was the last one
+         */
+		void SharedUnlock();
+
+		bool GetExclusiveLockStatus();
+
+		size_t GetSharedLockCount();
+
+		/**
+         * @brief How many times a waiter had to lend its priority or
+         *        its next event to the owner of this mutex
+         *
+         * @return size_t Priority inheritance counter
+         */
+		size_t GetInheritanceCount();
+
+	private:
+		enum LockType : size_t
+		{
+			shared    = 1,
+			exclusive = 2
+		};
+
+		/**
+         * @brief Grant the lock to the waiters at the head of the queue, if possible
+         */
+		void Dispatch();
+
+		/**
+         * @brief Lend the waiter priority and next event to the exclusive
+         *        owner, following the chain if the owner is itself blocked
+         *        on another mutex
+         *
+         * @param waiter    Thread about to block on this mutex
+         */
+		void Inherit(Thread &waiter);
+
+		/**
+         * @brief Make thread the exclusive owner, lending it the highest
+         *        priority among the threads still waiting
+         *
+         * @param thread    New owner
+         */
+		void SetOwner(Thread &thread);
+
+		/**
+         * @brief Give back what the owner no longer inherits, once a lock is
+         *        released or one of its waiters gave up, following the chain
+         *        if the owner is itself blocked on another mutex
+         *
+         * @param owner Thread whose priority is recomputed from the waiters
+         *              of the locks it still holds
+         */
+		static void Reinherit(Thread &owner);
+
+		bool m_bExclusiveLock      = false;
+		size_t m_nSharedLockCount  = 0;
+		size_t m_nExclusiveWaiters = 0;
+		size_t m_nInheritanceCount = 0;
+
+		Thread *m_pOwner = nullptr;
+
+		// Next lock held by the same owner
+		Mutex *m_pNextHeld = nullptr;
+
+		WaitList m_waitList;
+	};
+
+	/**
+     * @brief Scope based Mutex holder, releases whatever lock it still holds when destroyed
+     */
+	class SmartMutex
+	{
+	public:
+		SmartMutex() = delete;
+
+		SmartMutex(Mutex &mutex);
+
+		~SmartMutex();
+
+		bool Lock(Timeout tm = Timeout());
+
+		void Unlock();
+
+		bool SharedLock(Timeout tm = Timeout());
+
+		void SharedUnlock();
+
+		bool IsLocked();
+
+		bool IsShared();
+
+	private:
+		Mutex &m_mutex;
+		bool m_bLocked = false;
+		bool m_bShared = false;
+	};
+
+	/* *************************************************** *\
+        SEMAPHORE CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Counting semaphore
+     *
+     * @note    Waiters are served in FIFO order, Release hands the units
+     *          straight to the threads at the head of the queue, so a woken
+     *          thread never has to compete for them again.
+     */
+	class Semaphore
+	{
+	public:
+		/**
+         * @brief Construct a new Semaphore
+         *
+         * @param nInitial  Units available at start
+         * @param nMax      Maximum units the semaphore can hold
+         */
+		Semaphore(size_t nInitial = 0, size_t nMax = SIZE_MAX);
+
+		/**
+         * @brief Take one unit, waiting for it if none is available
+         *
+         * @param tm    Timeout, if 0 waits forever
+         *
+         * @return true if the unit was taken, false on timeout
+         */
+		bool Acquire(Timeout tm = Timeout());
+
+		/**
+         * @brief Take one unit only if available right now
+         *
+         * @return true if the unit was taken
+         */
+		bool TryAcquire();
+
+		/**
+         * @brief Give units back, waking one waiter per unit
+         *
+         * @param nCount    Number of units to give back
+         *
+         * @return false if it would exceed the maximum, nothing is released then
+         */
+		bool Release(size_t nCount = 1);
+
+		size_t GetCount();
+
+		size_t GetWaiting();
+
+	private:
+		size_t m_nCount;
+		size_t m_nMax;
+		size_t m_nWaiting = 0;
+
+		WaitList m_waitList;
+	};
+
+	/* *************************************************** *\
+        CONDITION VARIABLE CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Condition variable bound to a Mutex at wait time
+     *
+     * @note    Since the kernel is cooperative, nothing can run between
+     *          releasing the mutex and parking the thread, so no notification
+     *          is lost.
+     */
+	class ConditionVariable
+	{
+	public:
+		/**
+         * @brief Release the mutex and wait for a notification, the mutex is
+         *        locked again before returning, even on timeout
+         *
+         * @param mutex Mutex exclusively locked by the caller
+         * @param tm    Timeout, if 0 waits forever
+         *
+         * @return true if notified, false on timeout
+         */
+		bool Wait(Mutex &mutex, Timeout tm = Timeout());
+
+		/**
+         * @brief Wait till the predicate is true, see Wait(Mutex&, Timeout)
+         *
+         * @param mutex     Mutex exclusively locked by the caller
+         * @param predicate Condition checked with the mutex locked
+         * @param tm        Timeout, if 0 waits forever
+         *
+         * @return the last predicate result
+         */
+		template <typename P>
+		bool WaitFor(Mutex &mutex, P predicate, Timeout tm = Timeout())
+		{
+			while (!predicate())
+			{
+				if (!Wait(mutex, tm))
+				{
+					return predicate();
+				}
+			}
+
+			return true;
+		}
+
+		/**
+         * @brief Wake the oldest waiter
+         *
+         * @return size_t Number of threads woken
+         */
+		size_t NotifyOne();
+
+		/**
+         * @brief Wake all the waiters
+         *
+         * @return size_t Number of threads woken
+         */
+		size_t NotifyAll();
+
+	private:
+		size_t Wake(size_t nMax);
+
+		WaitList m_waitList;
+	};
+
+	/* *************************************************** *\
+        BARRIER CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Reusable barrier for a fixed number of threads
+     *
+     * @note    The last thread to arrive releases all the others at once and
+     *          starts a new generation, a thread that times out takes its
+     *          arrival back.
+     */
+	class Barrier
+	{
+	public:
+		Barrier() = delete;
+
+		/**
+         * @brief Construct a new Barrier
+         *
+         * @param nParties  Number of threads that must arrive to release it
+         */
+		Barrier(size_t nParties);
+
+		/**
+         * @brief Arrive and wait for the other parties
+         *
+         * @param tm    Timeout, if 0 waits forever
+         *
+         * @return true if the barrier was released, false on timeout
+         */
+		bool Wait(Timeout tm = Timeout());
+
+		size_t GetParties();
+
+		size_t GetArrived();
+
+		/**
+         * @brief How many times the barrier was released
+         *
+         * @return size_t Generation counter
+         */
+		size_t GetGeneration();
+
+	private:
+		size_t m_nParties;
+		size_t m_nArrived    = 0;
+		size_t m_nGeneration = 0;
+
+		WaitList m_waitList;
+	};
+
+	/* *************************************************** *\
+        CHANNEL CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Bounded FIFO of N items of type T between threads
+     *
+     * @tparam T    Item type, copied in and out of the ring
+     * @tparam N    Ring capacity in items
+     *
+     * @note    Senders block only while the ring is full, receivers only while
+     *          it is empty. The bulk calls move as many items as fit on each
+     *          turn, so a whole batch costs a single context switch.
+     */
+	template <typename T, size_t N>
+	class Channel
+	{
+	public:
+		/**
+         * @brief Append one item, waiting for room if the ring is full
+         *
+         * @param item  Item to send
+         * @param tm    Timeout, if 0 waits forever
+         *
+         * @return true if sent, false on timeout
+         */
+		bool Send(const T &item, Timeout tm = Timeout())
+		{
+			return Send(&item, 1, tm) == 1;
+		}
+
+		/**
+         * @brief Take the oldest item, waiting for one if the ring is empty
+         *
+         * @param item  Receives the item
+         * @param tm    Timeout, if 0 waits forever
+         *
+         * @return true if received, false on timeout
+         */
+		bool Receive(T &item, Timeout tm = Timeout())
+		{
+			return Receive(&item, 1, tm) == 1;
+		}
+
+		/**
+         * @brief Append all the items, waiting for room as many times as needed
+         *
+         * @param pItems    Items to send
+         * @param nCount    Number of items
+         * @param tm        Timeout, if 0 waits forever
+         *
+         * @return size_t Items sent, less than nCount only on timeout
+         */
+		size_t Send(const T *pItems, size_t nCount, Timeout tm = Timeout())
+		{
+			size_t nSent = 0;
+
+			Thread::PinCurrent();
+
+			while (nSent < nCount)
+			{
+				if (m_nCount == N)
+				{
+					if (!Block(m_senders, tm))
+					{
+						break;
+					}
+
+					continue;
+				}
+
+				for (; nSent < nCount && m_nCount < N; nSent++, m_nCount++)
+				{
+					m_ring[(m_nHead + m_nCount) % N] = pItems[nSent];
+				}
+
+				WakeFirst(m_receivers);
+			}
+
+			// Room left, the next sender may go as well
+			if (m_nCount < N)
+			{
+				WakeFirst(m_senders);
+			}
+
+			return nSent;
+		}
+
+		/**
+         * @brief Take up to nCount items, waiting only while the ring is empty
+         *
+         * @param pItems    Buffer for the items
+         * @param nCount    Buffer size in items
+         * @param tm        Timeout, if 0 waits forever
+         *
+         * @return size_t Items received, 0 only on timeout
+         */
+		size_t Receive(T *pItems, size_t nCount, Timeout tm = Timeout())
+		{
+			size_t nReceived = 0;
+
+			Thread::PinCurrent();
+
+			while (m_nCount == 0 && nCount > 0)
+			{
+				if (!Block(m_receivers, tm))
+				{
+					return 0;
+				}
+			}
+
+			for (; nReceived < nCount && m_nCount > 0; nReceived++, m_nCount--)
+			{
+				pItems[nReceived] = m_ring[m_nHead];
+				m_nHead           = (m_nHead + 1) % N;
+			}
+
+			if (nReceived > 0)
+			{
+				WakeFirst(m_senders);
+			}
+
+			// Items left, the next receiver may go as well
+			if (m_nCount > 0)
+			{
+				WakeFirst(m_receivers);
+			}
+
+			return nReceived;
+		}
+
+		size_t GetCount()
+		{
+			return m_nCount;
+		}
+
+		size_t GetCapacity()
+		{
+			return N;
+		}
+
+	private:
+		/**
+         * @brief Park the current thread till the other side wakes it up
+         *
+         * @return false on timeout
+         */
+		bool Block(WaitList &waitList, Timeout &tm)
+		{
+			if (tm.CanTimeout() && tm.IsTimedout())
+			{
+				return false;
+			}
+
+			return Thread::SafeBlock(waitList, Thread::NotifyChennelType::CHANNEL, this, 0, tm, Status::wait);
+		}
+
+		void WakeFirst(WaitList &waitList)
+		{
+			Thread *pThread = waitList.GetFirst();
+
+			if (pThread != nullptr)
+			{
+				pThread->WakeUp(m_nCount);
+			}
+		}
+
+		T m_ring[N];
+
+		size_t m_nHead  = 0;
+		size_t m_nCount = 0;
+
+		WaitList m_senders;
+		WaitList m_receivers;
+	};
+
+	/* *************************************************** *\
+        EVENT GROUP CLASS
+    \* *************************************************** */
+
+	/**
+     * @brief Word of event flags threads can wait on, for any or all of a mask
+     *
+     * @tparam F    Flag word, an unsigned integer no wider than size_t
+     *
+     * @note    Set checks every waiter against the same flag word in a single
+     *          pass over the queue, wakes the satisfied ones and clears the
+     *          bits they asked to consume only after the pass.
+     */
+	template <typename F = uint32_t>
+	class EventGroup
+	{
+		static_assert(sizeof(F) <= sizeof(size_t), "EventGroup flags must fit in a size_t");
+
+	public:
+		/**
+         * @brief Wait till any of the mask bits is set
+         *
+         * @param mask      Bits to wait for
+         * @param bClear    Clear the mask bits when satisfied
+         * @param tm        Timeout, if 0 waits forever
+         *
+         * @return F The mask bits that were set, 0 on timeout
+         */
+		F WaitAny(F mask, bool bClear = false, Timeout tm = Timeout())
+		{
+			return Wait(mask, false, bClear, tm);
+		}
+
+		/**
+         * @brief Wait till all the mask bits are set
+         *
+         * @param mask      Bits to wait for
+         * @param bClear    Clear the mask bits when satisfied
+         * @param tm        Timeout, if 0 waits forever
+         *
+         * @return F The mask, 0 on timeout
+         */
+		F WaitAll(F mask, bool bClear = false, Timeout tm = Timeout())
+		{
+			return Wait(mask, true, bClear, tm);
+		}
+
+		/**
+         * @brief Set bits and wake the waiters that are now satisfied
+         *
+         * @param mask  Bits to set
+         *
+         * @return F The flags after the waiters consumed their bits
+         */
+		F Set(F mask)
+		{
+			Thread::PinCurrent();
+
+			F flags = (m_flags |= mask);
+			F clear = 0;
+
+			Thread *pThread = m_waitList.GetFirst();
+
+			while (pThread != nullptr)
+			{
+				// WakeUp unlinks the thread
+				Thread *pNext = pThread->m_pWaitNext;
+				F wanted      = (F)pThread->m_messagectl.type;
+
+				if (IsSatisfied(flags, wanted, pThread->m_flags.eventAll))
+				{
+					if (pThread->m_flags.eventClear)
+					{
+						clear |= wanted;
+					}
+
+					pThread->WakeUp(flags & wanted);
+				}
+
+				pThread = pNext;
+			}
+
+			return (m_flags &= ~clear);
+		}
+
+		/**
+         * @brief Clear bits, no waiter is woken
+         *
+         * @param mask  Bits to clear
+         *
+         * @return F The flags before clearing
+         */
+		F Clear(F mask)
+		{
+			Thread::PinCurrent();
+
+			F flags = m_flags;
+
+			m_flags &= ~mask;
+
+			return flags;
+		}
+
+		F Get()
+		{
+			return m_flags;
+		}
+
+	private:
+		static bool IsSatisfied(F flags, F mask, bool bAll)
+		{
+			return bAll ? (flags & mask) == mask : (flags & mask) != 0;
+		}
+
+		F Wait(F mask, bool bAll, bool bClear, Timeout &tm)
+		{
+			Thread::PinCurrent();
+
+			if (IsSatisfied(m_flags, mask, bAll))
+			{
+				F flags = m_flags & mask;
+
+				if (bClear)
+				{
+					m_flags &= ~mask;
+				}
+
+				return flags;
+			}
+
+			if (mask == 0 || (tm.CanTimeout() && tm.IsTimedout()))
+			{
+				return 0;
+			}
+
+			Thread &thread = *Thread::m_pCurrent;
+
+			thread.m_flags.eventAll   = bAll;
+			thread.m_flags.eventClear = bClear;
+
+			if (!Thread::SafeBlock(m_waitList, Thread::NotifyChennelType::EVENT, this, mask, tm, Status::wait))
+			{
+				return 0;
+			}
+
+			return (F)thread.m_messagectl.message;
+		}
+
+		F m_flags = 0;
+
+		WaitList m_waitList;
 	};
 
 } // namespace atomicx
@@ -8,7 +8,7 @@
 #include "atomicx.hpp"
 
 #include <stdio.h>
-#include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <string.h>
@@ -19,25 +19,32 @@
 
 atomicx_time atomicx::Thread::GetTick (void)
 {
-    struct timeval tp;
-    gettimeofday (&tp, NULL);
+    struct timespec tp;
+    clock_gettime (CLOCK_MONOTONIC, &tp);
 
-    return (atomicx_time)tp.tv_sec * 1000 + tp.tv_usec / 1000;
+    return (atomicx_time)((uint64_t)tp.tv_sec * 1000 * ATOMICX_TICKS_PER_MS + (uint64_t)tp.tv_nsec * ATOMICX_TICKS_PER_MS / 1000000);
 }
 
 size_t nCounter = 0;
 
 void atomicx::Thread::SleepTick(atomicx_time nSleep)
 {
-    usleep ((useconds_t)nSleep * 1000);
+    usleep ((useconds_t)((uint64_t)nSleep * 1000 / ATOMICX_TICKS_PER_MS));
 }
 
 uint32_t nValue = 0;
 
+// A dedicated stack holds the whole call chain, libc included, a copied one only the live slice
+#ifdef ATOMICX_DEDICATED_STACK
+#define STACK_WORDS (ATOMICX_MIN_STACK_SIZE / sizeof (size_t) * 2)
+#else
+#define STACK_WORDS 100
+#endif
+
 class Reader : public atomicx::Thread
 {
     private:
-        volatile size_t nStack [100];
+        volatile size_t nStack [STACK_WORDS];
 
     public:
 
@@ -82,7 +89,7 @@ class Reader : public atomicx::Thread
 class Writer : public atomicx::Thread
 {
     private:
-        volatile size_t nStack [100];
+        volatile size_t nStack [STACK_WORDS];
 
     public:
 
@@ -111,7 +118,7 @@ class Writer : public atomicx::Thread
 
                 //TRACE (INFO, "Written value: [" << nValue << "], LocalValue: [" << nLocalValue << "], Stack: [" << GetStackSize () << "/" << GetMaxStackSize() << "]");
                 
-                Notify(nValue, {.type = 1, .message = nLocalValue}, 2000, atomicx::Notify::one);
+                Notify(nValue, {.message = nLocalValue, .type = 1}, 2000, atomicx::Notify::one);
                 
                 //Yield (0);
 
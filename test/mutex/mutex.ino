@@ -44,11 +44,33 @@ void PrintProcess (atomicx::Thread& endpoint)
         Serial.print (F ("/"));
         Serial.print ((uint32_t)th.GetNextEvent());
         Serial.print (F ("/"));
+#ifdef ATOMICX_ACCOUNTING
+        Serial.print ((int32_t)th.GetNextEvent() - (int32_t)atomicx::Thread::GetTick());
+
+        Serial.print (F ("\tRun:"));
+        Serial.print ((uint32_t)th.GetRunTicks());
+        Serial.print (F ("\tYields:"));
+        Serial.print (th.GetYieldCount());
+        Serial.print (F ("\tTimeouts:"));
+        Serial.print (th.GetTimeoutCount());
+        Serial.print (F ("\tWakeUps:"));
+        Serial.print (th.GetWakeUpsSent());
+        Serial.print (F ("/"));
+        Serial.print (th.GetWakeUpsReceived());
+        Serial.print (F ("\tPeak:"));
+        Serial.println (th.GetPeakStackSize());
+#else
         Serial.println ((int32_t)th.GetNextEvent() - (int32_t)atomicx::Thread::GetTick());
+#endif
 
         Serial.flush();
     }
 
+#ifdef ATOMICX_ACCOUNTING
+    Serial.print (F ("Idle: "));
+    Serial.println ((uint32_t)atomicx::Thread::GetIdleTicks());
+#endif
+
     Serial.println ("-------------------------------------");
 }
 
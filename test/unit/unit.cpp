@@ -0,0 +1,1492 @@
+//
+//  unit.cpp
+//  atomicx
+//
+//  Host unit tests for the kernel primitives, built and run by
+//  'make check' once per scheduler backend and context switch mode.
+//  Prints one line per test and exits non zero if any check failed.
+//
+
+#include "atomicx.hpp"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(ATOMICX_MULTICORE) || defined(ATOMICX_OUTSIDE_NOTIFY)
+#include <atomic>
+#include <thread>
+#endif
+
+/*
+ * Virtual clock: the idle kernel's SleepTick moves it by what was asked,
+ * so timing checks are exact whatever the host is doing. Idle periods in
+ * poll or epoll_wait skip SleepTick, the tests needing them switch to the
+ * real clock, and with a wake fd every idle period does.
+ */
+static uint64_t g_nNow      = 0;
+static uint64_t g_nRealBase = 0;
+
+#ifdef ATOMICX_OUTSIDE_WAKE
+static bool g_bRealTime = true;
+#else
+static bool g_bRealTime = false;
+#endif
+
+static uint64_t RealTicks()
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+
+    return (uint64_t)tp.tv_sec * 1000 * ATOMICX_TICKS_PER_MS + (uint64_t)tp.tv_nsec * ATOMICX_TICKS_PER_MS / 1000000;
+}
+
+static uint64_t Now()
+{
+    if (!g_bRealTime)
+    {
+        return g_nNow;
+    }
+
+    if (g_nRealBase == 0)
+    {
+        g_nRealBase = RealTicks() - g_nNow;
+    }
+
+    return RealTicks() - g_nRealBase;
+}
+
+#if defined(ATOMICX_REACTOR) || defined(ATOMICX_MULTICORE)
+/**
+ * @brief Switch clocks, the time goes on from where it was
+ */
+static void UseRealTime(bool bRealTime)
+{
+    g_nNow      = Now();
+    g_bRealTime = bRealTime;
+    g_nRealBase = bRealTime ? RealTicks() - g_nNow : 0;
+}
+#endif
+
+// Ticks wrap 150 ms in, while the tests run
+atomicx_time atomicx::Thread::GetTick(void)
+{
+    return (atomicx_time)Now() - (atomicx_time)(150 * ATOMICX_TICKS_PER_MS);
+}
+
+void atomicx::Thread::SleepTick(atomicx_time nSleep)
+{
+    if (g_bRealTime)
+    {
+        usleep((useconds_t)((uint64_t)nSleep * 1000 / ATOMICX_TICKS_PER_MS));
+    }
+    else
+    {
+        g_nNow += nSleep;
+    }
+}
+
+// Milliseconds to ticks, tests are written in ms
+#define MS(n) ((atomicx_time)(n) * ATOMICX_TICKS_PER_MS)
+
+static size_t g_nChecks   = 0;
+static size_t g_nFailures = 0;
+
+#define CHECK(cond)                                                      \
+    do                                                                   \
+    {                                                                    \
+        g_nChecks++;                                                     \
+        if (!(cond))                                                     \
+        {                                                                \
+            g_nFailures++;                                               \
+            printf("    FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        }                                                                \
+    } while (0)
+
+/*
+ * A thread that stays halted till Launch, runs one test body and halts
+ * again. Test state lives in globals: with the copy stack the stack of a
+ * switched out thread is not where its locals were.
+ */
+class Worker : public atomicx::Thread
+{
+public:
+    typedef void (*Body)(Worker &self);
+
+    Worker()
+        : Thread(0, m_stack)
+    {
+        Stop();
+    }
+
+    const char *GetName() override
+    {
+        return "Worker";
+    }
+
+    bool Launch(Body pBody, uint8_t nPriority = 0)
+    {
+        m_pBody = pBody;
+        SetPriority(nPriority);
+
+        return Start();
+    }
+
+    bool IsBusy()
+    {
+        return GetStatus() != atomicx::Status::halted;
+    }
+
+#ifdef ATOMICX_PERIODIC
+    void Periodic(atomicx_time nPeriod, atomicx_time nDeadline = 0)
+    {
+        SetPeriod(nPeriod, nDeadline);
+    }
+#endif
+
+#ifdef ATOMICX_REACTOR
+    bool Readable(int nFd, atomicx::Timeout tm)
+    {
+        return WaitReadable(nFd, tm);
+    }
+#endif
+
+#ifdef ATOMICX_DEDICATED_STACK
+    // Stands for an overflow that ran over the far end of stack[N]
+    void SetGuard(size_t nValue)
+    {
+        m_stack[0] = nValue;
+    }
+#endif
+
+    template <typename T>
+    size_t Send(T &endPoint, size_t nType, size_t nMessage, atomicx::Timeout tm, atomicx::Notify howMany = atomicx::Notify::one)
+    {
+        return Notify(endPoint, {nMessage, nType}, tm, howMany);
+    }
+
+    template <typename T>
+    size_t Receive(T &endPoint, size_t nType, size_t &nMessage, atomicx::Timeout tm)
+    {
+        return Wait(endPoint, nType, nMessage, tm);
+    }
+
+protected:
+    void run() override
+    {
+        m_pBody(*this);
+    }
+
+    bool OnExit() override
+    {
+        return false;
+    }
+
+private:
+    // Unbuffered printf alone takes a BUFSIZ buffer on a dedicated stack
+    volatile size_t m_stack[4096];
+
+    Body m_pBody = nullptr;
+};
+
+#define WORKERS 6
+
+static Worker g_workers[WORKERS];
+static Worker g_runner;
+
+// Halted on purpose by the stack checks
+static Worker g_victim;
+
+/**
+ * @brief Wait, from the runner, till no worker is busy
+ */
+static bool Settle(atomicx_time nMaxMs = 2000)
+{
+    atomicx::Timeout tm(MS(nMaxMs));
+
+    while (!tm.IsTimedout())
+    {
+        size_t nRunning = g_victim.IsBusy();
+
+        for (Worker &worker : g_workers)
+        {
+            nRunning += worker.IsBusy();
+        }
+
+        if (nRunning == 0)
+        {
+            return true;
+        }
+
+        atomicx::Thread::Yield(MS(1));
+    }
+
+    return false;
+}
+
+/* ------------------------------------------------------------------------ */
+
+static size_t g_order[WORKERS];
+static size_t g_nOrder = 0;
+
+static void SleepAndRecord(size_t nId, atomicx_time nSleep)
+{
+    atomicx::Thread::Yield(nSleep);
+    g_order[g_nOrder++] = nId;
+}
+
+static void TestWakeOrder(Worker &)
+{
+    g_nOrder = 0;
+
+    // Launched in the opposite order of their wake ups
+    g_workers[0].Launch([](Worker &) { SleepAndRecord(0, MS(30)); });
+    g_workers[1].Launch([](Worker &) { SleepAndRecord(1, MS(20)); });
+    g_workers[2].Launch([](Worker &) { SleepAndRecord(2, MS(10)); });
+
+    CHECK(Settle());
+    CHECK(g_nOrder == 3);
+    CHECK(g_order[0] == 2 && g_order[1] == 1 && g_order[2] == 0);
+}
+
+static int g_endPoint = 0;
+static size_t g_nWoken = 0;
+static size_t g_nLastMessage = 0;
+static size_t g_nResult = 0;
+
+static void TestForeverWait(Worker &)
+{
+    g_nWoken = 0;
+
+    g_workers[0].Launch([](Worker &self) {
+        size_t nMessage = 0;
+
+        g_nResult      = self.Receive(g_endPoint, 1, nMessage, 0);
+        g_nLastMessage = nMessage;
+        g_nWoken++;
+    });
+
+    // The waiter is the earliest thread for the whole sleep, it must not time out
+    atomicx::Thread::Yield(MS(30));
+    CHECK(g_nWoken == 0);
+
+    CHECK(g_runner.Send(g_endPoint, 1, 7, MS(100)) == 1);
+    CHECK(Settle());
+    CHECK(g_nWoken == 1);
+    CHECK(g_nResult == 1);
+    CHECK(g_nLastMessage == 7);
+}
+
+static void TestNotifyCounts(Worker &)
+{
+    g_nWoken = 0;
+
+    for (size_t nCount = 0; nCount < 3; nCount++)
+    {
+        g_workers[nCount].Launch([](Worker &self) {
+            size_t nMessage = 0;
+
+            if (self.Receive(g_endPoint, 2, nMessage, MS(1000)))
+            {
+                g_nWoken++;
+            }
+        });
+    }
+
+    atomicx::Thread::Yield(MS(5));
+
+    CHECK(g_runner.Send(g_endPoint, 2, 1, MS(100), atomicx::Notify::one) == 1);
+    atomicx::Thread::Yield(MS(5));
+    CHECK(g_nWoken == 1);
+
+    CHECK(g_runner.Send(g_endPoint, 2, 1, MS(100), atomicx::Notify::all) == 2);
+    CHECK(Settle());
+    CHECK(g_nWoken == 3);
+
+    // Nobody left waiting, a bounded notify gives up
+    CHECK(g_runner.Send(g_endPoint, 2, 1, MS(10), atomicx::Notify::all) == 0);
+}
+
+static atomicx::Mutex g_mutex;
+
+static void LockAndRecord(size_t nId)
+{
+    if (g_mutex.Lock(MS(1000)))
+    {
+        g_order[g_nOrder++] = nId;
+        g_mutex.Unlock();
+    }
+}
+
+static void TestMutexHandoff(Worker &)
+{
+    g_nOrder = 0;
+
+    CHECK(g_mutex.Lock());
+
+    // Queue the waiters one at a time so the FIFO order is known
+    g_workers[0].Launch([](Worker &) { LockAndRecord(1); });
+    atomicx::Thread::Yield(MS(2));
+    g_workers[1].Launch([](Worker &) { LockAndRecord(2); });
+    atomicx::Thread::Yield(MS(2));
+    g_workers[2].Launch([](Worker &) { LockAndRecord(3); });
+    atomicx::Thread::Yield(MS(2));
+
+    CHECK(g_nOrder == 0);
+
+    g_mutex.Unlock();
+
+    // Owned by the first waiter before it even runs
+    CHECK(g_mutex.GetExclusiveLockStatus());
+
+    CHECK(Settle());
+    CHECK(g_nOrder == 3);
+    CHECK(g_order[0] == 1 && g_order[1] == 2 && g_order[2] == 3);
+    CHECK(!g_mutex.GetExclusiveLockStatus());
+}
+
+static bool g_bReaderIn = false;
+
+static void TestWriterPreference(Worker &)
+{
+    g_nOrder    = 0;
+    g_bReaderIn = false;
+
+    CHECK(g_mutex.SharedLock());
+
+    g_workers[0].Launch([](Worker &) { LockAndRecord(1); });
+    atomicx::Thread::Yield(MS(2));
+
+    g_workers[1].Launch([](Worker &) {
+        if (g_mutex.SharedLock(MS(1000)))
+        {
+            g_bReaderIn         = true;
+            g_order[g_nOrder++] = 2;
+            g_mutex.SharedUnlock();
+        }
+    });
+    atomicx::Thread::Yield(MS(2));
+
+    // A writer is waiting, the new reader has to queue behind it
+    CHECK(!g_bReaderIn);
+    CHECK(g_mutex.GetSharedLockCount() == 1);
+
+    g_mutex.SharedUnlock();
+
+    CHECK(Settle());
+    CHECK(g_nOrder == 2);
+    CHECK(g_order[0] == 1 && g_order[1] == 2);
+    CHECK(g_mutex.GetSharedLockCount() == 0);
+}
+
+static uint8_t g_nHeldPriority  = 0;
+static uint8_t g_nAfterPriority = 0;
+
+static void TestPriorityInheritance(Worker &)
+{
+    size_t nInherited = g_mutex.GetInheritanceCount();
+
+    g_workers[0].Launch([](Worker &self) {
+        g_mutex.Lock();
+        atomicx::Thread::Yield(MS(20));
+        g_nHeldPriority = self.GetPriority();
+        g_mutex.Unlock();
+        g_nAfterPriority = self.GetPriority();
+    }, 1);
+    atomicx::Thread::Yield(MS(2));
+
+    g_workers[1].Launch([](Worker &) { LockAndRecord(1); }, 200);
+
+    CHECK(Settle());
+    CHECK(g_nHeldPriority == 200);
+    CHECK(g_nAfterPriority == 1);
+    CHECK(g_mutex.GetInheritanceCount() > nInherited);
+}
+
+static atomicx::Mutex g_otherMutex;
+static bool g_bRelease = false;
+static uint8_t g_nFirstPriority  = 0;
+static uint8_t g_nSecondPriority = 0;
+
+static void TestPriorityGiveBack(Worker &)
+{
+    Worker &owner = g_workers[0];
+
+    g_bRelease = false;
+
+    owner.Launch([](Worker &self) {
+        g_mutex.Lock();
+        g_otherMutex.Lock();
+
+        while (!g_bRelease)
+        {
+            atomicx::Thread::Yield(MS(1));
+        }
+
+        // Only the waiter of the lock still held keeps lending
+        g_otherMutex.Unlock();
+        g_nFirstPriority = self.GetPriority();
+        g_mutex.Unlock();
+        g_nSecondPriority = self.GetPriority();
+    }, 1);
+    atomicx::Thread::Yield(MS(2));
+
+    g_workers[1].Launch([](Worker &) { g_mutex.Lock(MS(10)); }, 200);
+    atomicx::Thread::Yield(MS(2));
+    CHECK(owner.GetPriority() == 200);
+
+    // The waiter gave up, nobody lends anything now
+    atomicx::Thread::Yield(MS(20));
+    CHECK(!g_workers[1].IsBusy());
+    CHECK(owner.GetPriority() == 1);
+
+    g_workers[2].Launch([](Worker &) { LockAndRecord(1); }, 50);
+    g_workers[3].Launch([](Worker &) {
+        if (g_otherMutex.Lock(MS(1000)))
+        {
+            g_otherMutex.Unlock();
+        }
+    }, 100);
+    atomicx::Thread::Yield(MS(2));
+    CHECK(owner.GetPriority() == 100);
+
+    g_bRelease = true;
+
+    CHECK(Settle());
+    CHECK(g_nFirstPriority == 50);
+    CHECK(g_nSecondPriority == 1);
+}
+
+static void TestTimeWrap(Worker &)
+{
+    atomicx_time nBefore = (atomicx_time)-MS(5);
+
+    CHECK(atomicx::IsTimeBefore(nBefore, MS(3)));
+    CHECK(!atomicx::IsTimeBefore(MS(3), nBefore));
+    CHECK(!atomicx::IsTimeBefore(nBefore, nBefore));
+
+    // The clock started right before the wrap, a sleep across it ends on time
+    atomicx_time nStart = atomicx::Thread::GetTick();
+
+    CHECK(atomicx::IsTimeBefore(nStart, 0));
+
+    atomicx::Thread::Yield(MS(160));
+
+    atomicx_time nElapsed = atomicx::Thread::GetTick() - nStart;
+
+    CHECK(!atomicx::IsTimeBefore(atomicx::Thread::GetTick(), 0));
+    CHECK(nElapsed >= MS(160));
+
+    // Exact on the virtual clock, the host may stall the real one
+    CHECK(g_bRealTime ? nElapsed < MS(400) : nElapsed == MS(160));
+}
+
+static atomicx::Channel<size_t, 4> g_channel;
+static size_t g_items[10];
+static size_t g_nSent = 0;
+static size_t g_nReceived = 0;
+
+static void TestChannel(Worker &)
+{
+    size_t nItem = 0;
+
+    g_nSent     = 0;
+    g_nReceived = 0;
+    g_nResult   = 0;
+
+    for (size_t nCount = 0; nCount < 10; nCount++)
+    {
+        g_items[nCount] = nCount + 100;
+    }
+
+    g_workers[0].Launch([](Worker &) { g_nSent = g_channel.Send(g_items, 10, MS(1000)); });
+    atomicx::Thread::Yield(MS(5));
+
+    // Ring full, the sender is parked with the rest of the batch
+    CHECK(g_channel.GetCount() == 4);
+    CHECK(g_nSent == 0);
+
+    g_workers[1].Launch([](Worker &) {
+        size_t buffer[3];
+        size_t nReceived;
+
+        while ((nReceived = g_channel.Receive(buffer, 3, MS(1000))) > 0)
+        {
+            for (size_t nCount = 0; nCount < nReceived; nCount++)
+            {
+                g_nResult += buffer[nCount] == 100 + g_nReceived++;
+            }
+        }
+    });
+
+    CHECK(Settle());
+    CHECK(g_nSent == 10);
+    CHECK(g_nReceived == 10);
+    CHECK(g_nResult == 10);
+
+    // Nothing left, a bounded receive gives up
+    CHECK(!g_channel.Receive(nItem, MS(10)));
+    CHECK(g_channel.GetCount() == 0);
+}
+
+/*
+ * Answers every notification of type 8 with the message plus one, type 9
+ */
+class EchoTask : public atomicx::Task
+{
+public:
+    EchoTask()
+        : Task(MS(1000))
+    {
+    }
+
+    const char *GetName() override
+    {
+        return "EchoTask";
+    }
+
+    void End()
+    {
+        Stop();
+    }
+
+    size_t m_nSteps    = 0;
+    size_t m_nTimeouts = 0;
+
+protected:
+    void Step() override
+    {
+        m_nSteps++;
+
+        if (GetStatus() == atomicx::Status::now)
+        {
+            Notify(g_endPoint, {GetMessage() + 1, 9});
+        }
+        else if (GetStatus() == atomicx::Status::timeout)
+        {
+            m_nTimeouts++;
+        }
+
+        Await(g_endPoint, 8, MS(20));
+    }
+};
+
+alignas(EchoTask) static unsigned char g_echoTask[sizeof(EchoTask)];
+
+static void TestTask(Worker &)
+{
+    EchoTask *pTask = new (g_echoTask) EchoTask();
+
+    atomicx::Thread::Yield(MS(5));
+    CHECK(pTask->m_nSteps == 1);
+
+    // Already waiting for the echo, the task may run before the notifier does
+    g_nLastMessage = 0;
+    g_workers[0].Launch([](Worker &self) {
+        size_t nMessage = 0;
+
+        self.Receive(g_endPoint, 9, nMessage, MS(1000));
+        g_nLastMessage = nMessage;
+    });
+    atomicx::Thread::Yield(MS(2));
+
+    CHECK(g_runner.Send(g_endPoint, 8, 41, MS(100)) == 1);
+    CHECK(Settle());
+    CHECK(g_nLastMessage == 42);
+    CHECK(pTask->m_nSteps == 2);
+
+    // Nobody notifies, its bounded Await keeps timing out
+    atomicx::Thread::Yield(MS(70));
+    CHECK(pTask->m_nTimeouts >= 2);
+
+    pTask->End();
+    CHECK(pTask->GetStatus() == atomicx::Status::halted);
+
+    pTask->~EchoTask();
+}
+
+static atomicx::ThreadPool<3, 4096> g_pool;
+static bool g_bGate = false;
+
+static void TestThreadPool(Worker &)
+{
+    g_bGate  = false;
+    g_nWoken = 0;
+
+    CHECK(g_pool.GetFreeCount() == 3);
+
+    for (size_t nCount = 1; nCount <= 3; nCount++)
+    {
+        CHECK(g_pool.Spawn([nCount]() {
+            while (!g_bGate)
+            {
+                atomicx::Thread::Yield(MS(1));
+            }
+
+            g_nWoken += nCount;
+        }));
+    }
+
+    // Every slot busy
+    CHECK(!g_pool.Spawn([]() {}));
+    CHECK(g_pool.GetFreeCount() == 0);
+
+    g_bGate = true;
+
+    for (atomicx::Timeout tm(MS(1000)); g_pool.GetFreeCount() < 3 && !tm.IsTimedout();)
+    {
+        atomicx::Thread::Yield(MS(1));
+    }
+
+    CHECK(g_pool.GetFreeCount() == 3);
+    CHECK(g_nWoken == 1 + 2 + 3);
+
+    // Reclaimed slots take new work
+    CHECK(g_pool.Spawn([]() { g_nWoken = 100; }));
+    atomicx::Thread::Yield(MS(5));
+    CHECK(g_nWoken == 100);
+    CHECK(g_pool.GetFreeCount() == 3);
+}
+
+#ifdef ATOMICX_TIMERS
+static size_t g_nExpiries = 0;
+
+static atomicx::Timer g_oneShot([](atomicx::Timer &, void *) { atomicx::Timer::Notify(g_endPoint, {5, 11}); });
+
+static atomicx::Timer g_periodic([](atomicx::Timer &timer, void *) {
+    // Stopping from its own callback
+    if (++g_nExpiries == 3)
+    {
+        timer.Stop();
+    }
+});
+
+static void TestTimers(Worker &)
+{
+    g_nLastMessage = 0;
+    g_nExpiries    = 0;
+
+    g_workers[0].Launch([](Worker &self) {
+        size_t nMessage = 0;
+
+        self.Receive(g_endPoint, 11, nMessage, 0);
+        g_nLastMessage = nMessage;
+    });
+    atomicx::Thread::Yield(MS(2));
+
+    CHECK(g_oneShot.Start(MS(20)));
+    CHECK(g_periodic.Start(MS(5), MS(5)));
+    CHECK(g_oneShot.IsActive() && g_periodic.IsActive());
+
+    CHECK(Settle());
+    CHECK(g_nLastMessage == 5);
+    CHECK(!g_oneShot.IsActive());
+
+    atomicx::Thread::Yield(MS(30));
+    CHECK(g_nExpiries == 3);
+    CHECK(!g_periodic.IsActive());
+    CHECK(!g_periodic.Stop());
+}
+#endif
+
+#ifdef ATOMICX_PERIODIC
+static atomicx_time g_nElapsed = 0;
+static size_t g_nMisses        = 0;
+static size_t g_nOverrunMisses = 0;
+static int32_t g_nWorstLate    = 0;
+
+static void TestPeriodic(Worker &)
+{
+    g_workers[0].Launch([](Worker &self) {
+        size_t nMisses      = self.GetDeadlineMisses();
+        atomicx_time nStart = atomicx::Thread::GetTick();
+
+        self.Periodic(MS(10));
+
+        // Each job takes 3 ms, the releases must not drift by it
+        for (size_t nCount = 0; nCount < 5; nCount++)
+        {
+            atomicx::Thread::Yield(MS(3));
+            atomicx::Thread::WaitNextPeriod();
+        }
+
+        g_nElapsed   = atomicx::Thread::GetTick() - nStart;
+        g_nMisses    = self.GetDeadlineMisses() - nMisses;
+        g_nWorstLate = self.GetWorstLate();
+
+        // Ends past its deadline, and the next release is dropped
+        atomicx::Thread::Yield(MS(25));
+        atomicx::Thread::WaitNextPeriod();
+
+        g_nOverrunMisses = self.GetDeadlineMisses() - nMisses;
+
+        self.Periodic(0);
+    });
+
+    CHECK(Settle());
+    CHECK(g_nElapsed == MS(50));
+    CHECK(g_nMisses == 0);
+    CHECK(g_nWorstLate == 0);
+    CHECK(g_nOverrunMisses == 2);
+}
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_EDF
+static void PeriodicJob(Worker &self, atomicx_time nDeadline, size_t nId)
+{
+    self.Periodic(MS(50), nDeadline);
+    atomicx::Thread::WaitNextPeriod();
+
+    g_order[g_nOrder++] = nId;
+
+    self.Periodic(0);
+}
+
+static void TestEarliestDeadline(Worker &)
+{
+    g_nOrder = 0;
+
+    // Released first, but with the later deadline
+    g_workers[0].Launch([](Worker &self) { PeriodicJob(self, MS(40), 1); });
+    g_workers[1].Launch([](Worker &self) { PeriodicJob(self, MS(10), 2); });
+    atomicx::Thread::Yield(MS(2));
+
+    // Stands for running 70 ms without yielding, both releases are then due together
+    g_nNow += MS(70);
+
+    CHECK(Settle());
+    CHECK(g_nOrder == 2);
+    CHECK(g_order[0] == 2 && g_order[1] == 1);
+}
+#endif
+
+static atomicx::Semaphore g_units(0, 3);
+
+static void AcquireAndRecord(size_t nId)
+{
+    if (g_units.Acquire(MS(1000)))
+    {
+        g_order[g_nOrder++] = nId;
+    }
+}
+
+static void TestSemaphore(Worker &)
+{
+    g_nOrder = 0;
+
+    // Queue the waiters one at a time so the FIFO order is known
+    g_workers[0].Launch([](Worker &) { AcquireAndRecord(1); });
+    atomicx::Thread::Yield(MS(2));
+    g_workers[1].Launch([](Worker &) { AcquireAndRecord(2); });
+    atomicx::Thread::Yield(MS(2));
+    g_workers[2].Launch([](Worker &) { AcquireAndRecord(3); });
+    atomicx::Thread::Yield(MS(2));
+
+    CHECK(g_units.GetWaiting() == 3);
+
+    // Handed straight to the two oldest waiters, nothing is left to take
+    CHECK(g_units.Release(2));
+    CHECK(g_units.GetCount() == 0);
+    CHECK(!g_units.TryAcquire());
+
+    atomicx::Thread::Yield(MS(2));
+    CHECK(g_nOrder == 2);
+    CHECK(g_order[0] == 1 && g_order[1] == 2);
+
+    CHECK(g_units.Release());
+    CHECK(Settle());
+    CHECK(g_nOrder == 3);
+    CHECK(g_order[2] == 3);
+
+    // Nobody waiting, the units are kept up to the maximum
+    CHECK(g_units.Release(3));
+    CHECK(!g_units.Release());
+    CHECK(g_units.GetCount() == 3);
+
+    CHECK(g_units.TryAcquire());
+    CHECK(g_units.TryAcquire());
+    CHECK(g_units.TryAcquire());
+    CHECK(!g_units.TryAcquire());
+
+    CHECK(!g_units.Acquire(MS(5)));
+    CHECK(g_units.GetWaiting() == 0);
+}
+
+static atomicx::ConditionVariable g_condition;
+
+static void WaitCondition(Worker &)
+{
+    if (g_mutex.Lock(MS(1000)))
+    {
+        if (g_condition.Wait(g_mutex, MS(1000)))
+        {
+            g_nWoken++;
+        }
+
+        g_mutex.Unlock();
+    }
+}
+
+static void TestConditionVariable(Worker &)
+{
+    g_nWoken = 0;
+
+    for (size_t nCount = 0; nCount < 3; nCount++)
+    {
+        g_workers[nCount].Launch(WaitCondition);
+    }
+
+    atomicx::Thread::Yield(MS(5));
+
+    // Notified while the mutex is held, the waiter returns only once it gets it back
+    CHECK(g_mutex.Lock(MS(100)));
+    CHECK(g_condition.NotifyOne() == 1);
+    atomicx::Thread::Yield(MS(5));
+    CHECK(g_nWoken == 0);
+
+    g_mutex.Unlock();
+    atomicx::Thread::Yield(MS(5));
+    CHECK(g_nWoken == 1);
+
+    CHECK(g_condition.NotifyAll() == 2);
+    CHECK(Settle());
+    CHECK(g_nWoken == 3);
+
+    CHECK(g_condition.NotifyAll() == 0);
+
+    // A timed out wait still returns with the mutex locked
+    CHECK(g_mutex.Lock(MS(100)));
+    CHECK(!g_condition.Wait(g_mutex, MS(5)));
+
+    g_nResult = 1;
+    g_workers[0].Launch([](Worker &) { g_nResult = g_mutex.Lock(MS(5)); });
+    CHECK(Settle());
+    CHECK(g_nResult == 0);
+
+    g_mutex.Unlock();
+}
+
+static atomicx::Barrier g_barrier(3);
+static size_t g_nPassed = 0;
+
+static void TestBarrier(Worker &)
+{
+    g_nPassed = 0;
+
+    size_t nGeneration = g_barrier.GetGeneration();
+
+    for (size_t nCount = 0; nCount < 2; nCount++)
+    {
+        g_workers[nCount].Launch([](Worker &) {
+            for (size_t nRound = 0; nRound < 2; nRound++)
+            {
+                if (g_barrier.Wait(MS(1000)))
+                {
+                    g_nPassed++;
+                }
+            }
+        });
+    }
+
+    atomicx::Thread::Yield(MS(5));
+    CHECK(g_barrier.GetArrived() == 2);
+    CHECK(g_nPassed == 0);
+
+    // The last party releases the others without blocking
+    CHECK(g_barrier.Wait(MS(1000)));
+    CHECK(g_barrier.GetGeneration() == nGeneration + 1);
+    CHECK(g_barrier.GetArrived() == 0);
+
+    // Reused right away by the next round
+    atomicx::Thread::Yield(MS(5));
+    CHECK(g_nPassed == 2);
+    CHECK(g_barrier.GetArrived() == 2);
+
+    CHECK(g_barrier.Wait(MS(1000)));
+    CHECK(Settle());
+    CHECK(g_nPassed == 4);
+    CHECK(g_barrier.GetGeneration() == nGeneration + 2);
+
+    // A party that times out takes its arrival back
+    CHECK(!g_barrier.Wait(MS(5)));
+    CHECK(g_barrier.GetArrived() == 0);
+    CHECK(g_barrier.GetGeneration() == nGeneration + 2);
+}
+
+static atomicx::EventGroup<uint32_t> g_events;
+static uint32_t g_got[WORKERS];
+
+static void WaitEvents(size_t nId, uint32_t mask, bool bAll, bool bClear)
+{
+    g_got[nId] = bAll ? g_events.WaitAll(mask, bClear, MS(1000)) : g_events.WaitAny(mask, bClear, MS(1000));
+    g_nWoken++;
+}
+
+static void TestEventGroup(Worker &)
+{
+    g_nWoken = 0;
+
+    g_workers[0].Launch([](Worker &) { WaitEvents(0, 0x3, false, false); });
+    g_workers[1].Launch([](Worker &) { WaitEvents(1, 0x5, true, true); });
+    g_workers[2].Launch([](Worker &) { WaitEvents(2, 0x4, false, true); });
+    atomicx::Thread::Yield(MS(5));
+    CHECK(g_nWoken == 0);
+
+    // Only the any waiter is satisfied, it consumes nothing
+    CHECK(g_events.Set(0x1) == 0x1);
+    atomicx::Thread::Yield(MS(5));
+    CHECK(g_nWoken == 1);
+    CHECK(g_got[0] == 0x1);
+
+    // One Set wakes both, and both see the bits before either one clears them
+    CHECK(g_events.Set(0x4) == 0);
+    CHECK(Settle());
+    CHECK(g_nWoken == 3);
+    CHECK(g_got[1] == 0x5);
+    CHECK(g_got[2] == 0x4);
+
+    // Already set, no blocking
+    g_events.Set(0x2);
+    CHECK(g_events.WaitAll(0x2, true, MS(5)) == 0x2);
+    CHECK(g_events.Get() == 0);
+
+    // Part of the mask is not enough for all, and a timeout leaves the bits as they were
+    g_events.Set(0x1);
+    CHECK(g_events.WaitAll(0x3, true, MS(5)) == 0);
+    CHECK(g_events.Clear(0x1) == 0x1);
+    CHECK(g_events.Get() == 0);
+}
+
+#ifdef ATOMICX_EVENT_TRACE
+static uint8_t g_dump[sizeof(atomicx::TraceFileHeader) + (WORKERS + 2) * sizeof(atomicx::TraceFileThread) +
+                      ATOMICX_EVENT_TRACE_SIZE * sizeof(atomicx::TraceFileEvent)];
+static size_t g_nDump = 0;
+
+static void DumpToMemory(const void *pData, size_t nSize, void *)
+{
+    if (g_nDump + nSize <= sizeof(g_dump))
+    {
+        memcpy(g_dump + g_nDump, pData, nSize);
+    }
+
+    g_nDump += nSize;
+}
+
+static void TestEventTrace(Worker &)
+{
+    atomicx::Thread::ClearTrace();
+
+    g_workers[0].Launch([](Worker &self) {
+        size_t nMessage = 0;
+
+        self.Receive(g_endPoint, 3, nMessage, MS(1000));
+    });
+    atomicx::Thread::Yield(MS(2));
+
+    CHECK(g_runner.Send(g_endPoint, 3, 9, MS(100)) == 1);
+    CHECK(Settle());
+
+    g_nDump = 0;
+    atomicx::Thread::DumpTrace(DumpToMemory, nullptr);
+
+    atomicx::TraceFileHeader header;
+    memcpy(&header, g_dump, sizeof(header));
+
+    CHECK(header.nMagic == ATOMICX_TRACE_MAGIC);
+    CHECK(g_nDump == sizeof(header) + header.nThreads * sizeof(atomicx::TraceFileThread) + header.nEvents * sizeof(atomicx::TraceFileEvent));
+    CHECK(g_nDump <= sizeof(g_dump));
+
+    bool bWait   = false;
+    bool bNotify = false;
+    bool bSwitch = false;
+
+    for (size_t nCount = 0; nCount < header.nEvents && g_nDump <= sizeof(g_dump); nCount++)
+    {
+        atomicx::TraceFileEvent event;
+
+        memcpy(&event, g_dump + sizeof(header) + header.nThreads * sizeof(atomicx::TraceFileThread) + nCount * sizeof(event), sizeof(event));
+
+        bWait   = bWait || (event.type == (uint8_t)atomicx::TraceType::wait && event.nFrom == (uintptr_t)&g_workers[0] && event.nValue == (uintptr_t)&g_endPoint);
+        bNotify = bNotify || (event.type == (uint8_t)atomicx::TraceType::notify && event.nFrom == (uintptr_t)&g_runner && event.nTo == (uintptr_t)&g_workers[0] && event.nValue == 9);
+        bSwitch = bSwitch || (event.type == (uint8_t)atomicx::TraceType::contextSwitch && event.nTo == (uintptr_t)&g_workers[0]);
+    }
+
+    CHECK(bWait);
+    CHECK(bNotify);
+    CHECK(bSwitch);
+}
+#endif
+
+#ifdef ATOMICX_ACCOUNTING
+static size_t g_nYields   = 0;
+static size_t g_nTimeouts = 0;
+static size_t g_nWakeUps  = 0;
+
+static void TestAccounting(Worker &)
+{
+    Worker &worker = g_workers[0];
+    size_t nSent   = g_runner.GetWakeUpsSent();
+
+    worker.Launch([](Worker &self) {
+        size_t nMessage = 0;
+
+        // Counted from here, whatever ran on this worker before
+        g_nYields   = self.GetYieldCount();
+        g_nTimeouts = self.GetTimeoutCount();
+        g_nWakeUps  = self.GetWakeUpsReceived();
+
+        for (size_t nCount = 0; nCount < 5; nCount++)
+        {
+            atomicx::Thread::Yield(MS(1));
+        }
+
+        self.Receive(g_endPoint, 4, nMessage, MS(5));
+        self.Receive(g_endPoint, 4, nMessage, MS(1000));
+
+        // Up to here, not what the worker does once the body returns
+        g_nYields   = self.GetYieldCount() - g_nYields;
+        g_nTimeouts = self.GetTimeoutCount() - g_nTimeouts;
+        g_nWakeUps  = self.GetWakeUpsReceived() - g_nWakeUps;
+    });
+
+    atomicx::Thread::Yield(MS(30));
+
+    CHECK(g_runner.Send(g_endPoint, 4, 1, MS(100)) == 1);
+    CHECK(Settle());
+
+    // 5 yields and 2 blocking waits, one timed out and one woken
+    CHECK(g_nYields == 7);
+    CHECK(g_nTimeouts == 1);
+    CHECK(g_nWakeUps == 1);
+    CHECK(g_runner.GetWakeUpsSent() - nSent == 1);
+    CHECK(worker.GetPeakStackSize() > 0);
+    CHECK(worker.GetPeakStackSize() <= worker.GetMaxStackSize());
+}
+#endif
+
+#ifdef ATOMICX_REACTOR
+static int g_pipe[2];
+
+static void TestReactor(Worker &)
+{
+    char nByte = 0;
+
+    g_nWoken  = 0;
+    g_nResult = 0;
+
+    CHECK(pipe(g_pipe) == 0);
+
+    // Idle periods are spent in epoll_wait
+    UseRealTime(true);
+
+    g_workers[0].Launch([](Worker &self) {
+        // Empty pipe, the bounded wait gives up
+        g_nResult = self.Readable(g_pipe[0], MS(10)) ? 1 : 2;
+
+        if (self.Readable(g_pipe[0], MS(1000)))
+        {
+            g_nWoken++;
+        }
+    });
+
+    atomicx::Thread::Yield(MS(40));
+    CHECK(g_nResult == 2);
+    CHECK(g_nWoken == 0);
+
+    CHECK(write(g_pipe[1], "x", 1) == 1);
+    CHECK(Settle());
+    CHECK(g_nWoken == 1);
+    CHECK(read(g_pipe[0], &nByte, 1) == 1 && nByte == 'x');
+
+    close(g_pipe[0]);
+    close(g_pipe[1]);
+
+    // Back to the clock the build runs on
+#ifdef ATOMICX_OUTSIDE_WAKE
+    UseRealTime(true);
+#else
+    UseRealTime(false);
+#endif
+}
+#endif
+
+#ifdef ATOMICX_OUTSIDE_NOTIFY
+static void TestOutsideNotify(Worker &)
+{
+    size_t nMessage = 0;
+
+    g_nLastMessage = 0;
+
+    g_workers[0].Launch([](Worker &self) {
+        size_t nMessage = 0;
+
+        if (self.Receive(g_endPoint, 5, nMessage, 0))
+        {
+            g_nLastMessage = nMessage;
+            self.Send(g_endPoint, 6, 1, MS(100));
+        }
+    });
+    atomicx::Thread::Yield(MS(2));
+
+    std::thread([] {
+        usleep(20000);
+        atomicx::Thread::NotifyFromOutside(g_endPoint, {42, 5});
+    }).detach();
+
+    // Both wait, nothing is due: only the wake fd ends the idle period early
+    atomicx_time nStart = atomicx::Thread::GetTick();
+
+    CHECK(g_runner.Receive(g_endPoint, 6, nMessage, MS(2000)) == 1);
+    CHECK(atomicx::Thread::GetTick() - nStart < MS(500));
+    CHECK(Settle());
+    CHECK(g_nLastMessage == 42);
+}
+#endif
+
+#if !defined(ATOMICX_DEDICATED_STACK) && ATOMICX_STACK_CHECK == ATOMICX_STACK_CHECK_HALT
+static void TestStackOverflow(Worker &)
+{
+    g_nWoken = 0;
+
+    g_victim.Launch([](Worker &) {
+        // Past the worker's stack[4096], it runs on the Join stack till Yield saves it
+        volatile uint8_t buffer[4096 * sizeof(size_t) + 256];
+
+        buffer[0]                  = 1;
+        buffer[sizeof(buffer) - 1] = 1;
+
+        atomicx::Thread::Yield(0);
+        g_nWoken++;
+    });
+
+    CHECK(Settle());
+    CHECK(g_nWoken == 0);
+    CHECK(g_victim.GetStatus() == atomicx::Status::halted);
+
+    // Nothing of it was saved, it starts over clean
+    g_victim.Launch([](Worker &) {
+        atomicx::Thread::Yield(0);
+        g_nWoken++;
+    });
+
+    CHECK(Settle());
+    CHECK(g_nWoken == 1);
+}
+#endif
+
+#if defined(ATOMICX_DEDICATED_STACK) && ATOMICX_STACK_CHECK == ATOMICX_STACK_CHECK_HALT
+static void TestStackGuard(Worker &)
+{
+    g_nWoken = 0;
+
+    g_victim.Launch([](Worker &self) {
+        self.SetGuard(0);
+        atomicx::Thread::Yield(0);
+        g_nWoken++;
+    });
+
+    CHECK(Settle());
+    CHECK(g_nWoken == 0);
+    CHECK(g_victim.GetStatus() == atomicx::Status::halted);
+
+    g_victim.SetGuard(ATOMICX_STACK_CANARY);
+}
+#endif
+
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+static void YieldAndRecord(size_t nId)
+{
+    for (size_t nCount = 0; nCount < 2; nCount++)
+    {
+        // The clock stands still while they run, all three wake on the same tick
+        atomicx::Thread::Yield(MS(5));
+        g_order[g_nOrder++] = nId;
+    }
+}
+
+static void TestHeapTies(Worker &)
+{
+    g_nOrder = 0;
+
+    g_workers[0].Launch([](Worker &) { YieldAndRecord(0); }, 10);
+    g_workers[1].Launch([](Worker &) { YieldAndRecord(1); }, 10);
+    g_workers[2].Launch([](Worker &) { YieldAndRecord(2); }, 10);
+
+    CHECK(Settle());
+    CHECK(g_nOrder == 6);
+
+    CHECK(g_order[0] != g_order[1] && g_order[1] != g_order[2] && g_order[0] != g_order[2]);
+
+    // Equal keys run in the order they were re-keyed, the first round sets it
+    for (size_t nCount = 3; nCount < g_nOrder; nCount++)
+    {
+        CHECK(g_order[nCount] == g_order[nCount - 3]);
+    }
+}
+
+#define CAPACITY ATOMICX_SCHED_HEAP_SIZE
+#elif ATOMICX_SCHEDULER == ATOMICX_SCHED_TABLE || ATOMICX_SCHEDULER == ATOMICX_SCHED_PRIO
+#define CAPACITY ATOMICX_MAX_THREADS
+#endif
+
+#ifdef CAPACITY
+/*
+ * Never runs, only constructed and destroyed by the runner without
+ * yielding in between
+ */
+class Probe : public atomicx::Thread
+{
+public:
+    Probe()
+        : Thread(0, m_stack)
+    {
+    }
+
+    const char *GetName() override
+    {
+        return "Probe";
+    }
+
+protected:
+    void run() override
+    {
+    }
+
+private:
+    volatile size_t m_stack[32 + ATOMICX_MIN_STACK_SIZE / sizeof(size_t)];
+};
+
+class ProbeTask : public atomicx::Task
+{
+public:
+    ProbeTask()
+        : Task(0)
+    {
+    }
+
+    const char *GetName() override
+    {
+        return "ProbeTask";
+    }
+
+protected:
+    void Step() override
+    {
+    }
+};
+
+alignas(Probe) static unsigned char g_probes[CAPACITY + 1][sizeof(Probe)];
+alignas(ProbeTask) static unsigned char g_probeTask[sizeof(ProbeTask)];
+
+static void TestAttachCapacity(Worker &self)
+{
+    size_t nBefore = self.GetThreadCount();
+    size_t nFree   = CAPACITY - nBefore;
+
+    for (size_t nCount = 0; nCount <= nFree; nCount++)
+    {
+        new (g_probes[nCount]) Probe();
+    }
+
+    for (size_t nCount = 0; nCount < nFree; nCount++)
+    {
+        CHECK(reinterpret_cast<Probe *>(g_probes[nCount])->GetStatus() != atomicx::Status::halted);
+    }
+
+    // One past the capacity, constructed but left halted and out of the scheduler
+    CHECK(reinterpret_cast<Probe *>(g_probes[nFree])->GetStatus() == atomicx::Status::halted);
+    CHECK(self.GetThreadCount() == CAPACITY);
+
+    // Tasks take the other constructor, same outcome
+    ProbeTask *pTask = new (g_probeTask) ProbeTask();
+
+    CHECK(pTask->GetStatus() == atomicx::Status::halted);
+    CHECK(self.GetThreadCount() == CAPACITY);
+
+    pTask->~ProbeTask();
+
+    for (size_t nCount = nFree + 1; nCount > 0; nCount--)
+    {
+        reinterpret_cast<Probe *>(g_probes[nCount - 1])->~Probe();
+    }
+
+    CHECK(self.GetThreadCount() == nBefore);
+}
+#endif
+
+#ifdef ATOMICX_MULTICORE
+static atomicx::Mutex g_pinMutex;
+static std::atomic<size_t> g_moves[WORKERS];
+
+static void Roam(Worker &)
+{
+    atomicx::Kernel *pKernel = &atomicx::Thread::GetKernel();
+    size_t nId               = 0;
+
+    while (&g_workers[nId] != atomicx::Thread::GetCurrent())
+    {
+        nId++;
+    }
+
+    if (nId == 0)
+    {
+        atomicx::Thread::GetCurrent()->SetPinned(true);
+    }
+    else if (nId == 1)
+    {
+        g_pinMutex.Lock();
+        g_pinMutex.Unlock();
+    }
+    else
+    {
+        // Done with the objects earlier tests pinned it for
+        atomicx::Thread::GetCurrent()->SetPinned(false);
+    }
+
+    for (size_t nCount = 0; nCount < 200; nCount++)
+    {
+        atomicx::Thread::Yield(MS(1));
+
+        if (&atomicx::Thread::GetKernel() != pKernel)
+        {
+            pKernel = &atomicx::Thread::GetKernel();
+            g_moves[nId]++;
+        }
+    }
+}
+
+static void TestPinnedStay(Worker &)
+{
+    // Runs last, the second instance keeps stealing till exit on the same clock
+    UseRealTime(true);
+
+    std::thread([] { atomicx::Thread::Join(); }).detach();
+
+    for (size_t nCount = 0; nCount < WORKERS; nCount++)
+    {
+        g_moves[nCount] = 0;
+        g_workers[nCount].Launch(Roam);
+    }
+
+    CHECK(Settle(5000));
+
+    // Explicitly pinned, and pinned by using a Mutex
+    CHECK(g_moves[0] == 0);
+    CHECK(g_moves[1] == 0);
+
+    size_t nMoves = 0;
+
+    for (size_t nCount = 2; nCount < WORKERS; nCount++)
+    {
+        nMoves += g_moves[nCount];
+    }
+
+    CHECK(nMoves > 0);
+}
+#endif
+
+/* ------------------------------------------------------------------------ */
+
+struct UnitTest
+{
+    const char *pName;
+    void (*pTest)(Worker &self);
+};
+
+static const UnitTest g_tests[] = {
+    {"time wrap", TestTimeWrap},
+    {"sleepers wake in order", TestWakeOrder},
+    {"forever wait", TestForeverWait},
+    {"notify one/all", TestNotifyCounts},
+    {"mutex FIFO hand-off", TestMutexHandoff},
+    {"mutex writer preference", TestWriterPreference},
+    {"priority inheritance", TestPriorityInheritance},
+    {"priority given back", TestPriorityGiveBack},
+    {"channel batches", TestChannel},
+    {"task echo", TestTask},
+    {"thread pool reuse", TestThreadPool},
+#ifdef ATOMICX_TIMERS
+    {"timers one-shot/periodic", TestTimers},
+#endif
+#ifdef ATOMICX_PERIODIC
+    {"periodic without drift", TestPeriodic},
+#endif
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_EDF
+    {"earliest deadline first", TestEarliestDeadline},
+#endif
+    {"semaphore hand-off", TestSemaphore},
+    {"condition variable", TestConditionVariable},
+    {"barrier generations", TestBarrier},
+    {"event group any/all", TestEventGroup},
+#ifdef ATOMICX_EVENT_TRACE
+    {"event trace", TestEventTrace},
+#endif
+#ifdef ATOMICX_ACCOUNTING
+    {"accounting counters", TestAccounting},
+#endif
+#ifdef ATOMICX_REACTOR
+    {"reactor readable", TestReactor},
+#endif
+#ifdef ATOMICX_OUTSIDE_NOTIFY
+    {"notify from outside", TestOutsideNotify},
+#endif
+#if !defined(ATOMICX_DEDICATED_STACK) && ATOMICX_STACK_CHECK == ATOMICX_STACK_CHECK_HALT
+    {"stack overflow halts", TestStackOverflow},
+#endif
+#if defined(ATOMICX_DEDICATED_STACK) && ATOMICX_STACK_CHECK == ATOMICX_STACK_CHECK_HALT
+    {"stack guard", TestStackGuard},
+#endif
+#if ATOMICX_SCHEDULER == ATOMICX_SCHED_HEAP
+    {"heap ties in re-key order", TestHeapTies},
+#endif
+#ifdef CAPACITY
+    {"attach past capacity", TestAttachCapacity},
+#endif
+#ifdef ATOMICX_MULTICORE
+    {"pinned threads stay", TestPinnedStay},
+#endif
+};
+
+static void RunAll(Worker &self)
+{
+    for (const UnitTest &test : g_tests)
+    {
+        size_t nFailures = g_nFailures;
+
+        test.pTest(self);
+
+        bool bSettled = Settle();
+
+        if (!bSettled)
+        {
+            printf("    FAILED: workers still running\n");
+            g_nFailures++;
+        }
+
+        printf("%-28s %s\n", test.pName, g_nFailures == nFailures ? "ok" : "FAILED");
+
+        // A stuck worker would poison the next tests
+        if (!bSettled)
+        {
+            break;
+        }
+    }
+
+    printf("%zu checks, %zu failures\n", g_nChecks, g_nFailures);
+
+    exit(g_nFailures == 0 ? 0 : 1);
+}
+
+int main()
+{
+    setvbuf(stdout, nullptr, _IONBF, 0);
+
+    g_runner.Launch(RunAll);
+
+    atomicx::Thread::Join();
+
+    return 1;
+}
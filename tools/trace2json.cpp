@@ -0,0 +1,250 @@
+//
+//  trace2json.cpp
+//  atomicx
+//
+//  Converts a Thread::DumpTrace dump into Chrome trace JSON, open the
+//  result with chrome://tracing or https://ui.perfetto.dev
+//
+//  usage: trace2json.bin <dump> [tick in us, default 1000] > trace.json
+//
+
+#include "atomicx.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Only GetStatusName is used from the kernel, the clock is never read.
+ */
+
+atomicx_time atomicx::Thread::GetTick(void)
+{
+    return 0;
+}
+
+void atomicx::Thread::SleepTick(atomicx_time nSleep)
+{
+    (void)nSleep;
+}
+
+static const char *GetStatus(uint8_t status)
+{
+    return atomicx::GetStatusName((atomicx::Status)status);
+}
+
+class Converter
+{
+private:
+    std::map<uint64_t, size_t> m_tids;
+    std::map<uint64_t, std::string> m_names;
+    std::map<size_t, double> m_running;
+
+    double m_idleStart = -1;
+    double m_tickUs;
+    bool m_bFirst = true;
+
+    void Emit(const std::string &event)
+    {
+        printf("%s\n    %s", m_bFirst ? "" : ",", event.c_str());
+        m_bFirst = false;
+    }
+
+    std::string GetName(uint64_t nId)
+    {
+        auto it = m_names.find(nId);
+
+        if (it != m_names.end())
+        {
+            return it->second;
+        }
+
+        char name[32];
+        snprintf(name, sizeof(name), "0x%llx", (unsigned long long)nId);
+
+        return name;
+    }
+
+    // tid 0 is the kernel itself, threads are numbered as they show up
+    size_t GetTid(uint64_t nId)
+    {
+        if (nId == 0)
+        {
+            return 0;
+        }
+
+        auto it = m_tids.find(nId);
+
+        if (it != m_tids.end())
+        {
+            return it->second;
+        }
+
+        size_t nTid = m_tids.size() + 1;
+        m_tids[nId] = nTid;
+
+        char event[256];
+        snprintf(event, sizeof(event), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}", nTid,
+                 GetName(nId).c_str());
+        Emit(event);
+
+        return nTid;
+    }
+
+    void Slice(const char *pName, size_t nTid, double start, double end, const char *pArgs)
+    {
+        char event[256];
+
+        snprintf(event, sizeof(event), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f,\"args\":{%s}}", pName,
+                 nTid, start, end - start, pArgs);
+        Emit(event);
+    }
+
+    void Instant(const char *pName, size_t nTid, double ts, const char *pArgs)
+    {
+        char event[256];
+
+        snprintf(event, sizeof(event), "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"args\":{%s}}", pName, nTid,
+                 ts, pArgs);
+        Emit(event);
+    }
+
+public:
+    Converter(double tickUs)
+        : m_tickUs(tickUs)
+    {
+    }
+
+    void AddThread(const atomicx::TraceFileThread &thread)
+    {
+        m_names[thread.nId] = std::string(thread.name, strnlen(thread.name, sizeof(thread.name)));
+    }
+
+    void AddEvent(const atomicx::TraceFileEvent &event)
+    {
+        double ts = (double)event.nTick * m_tickUs;
+        char args[160];
+
+        switch ((atomicx::TraceType)event.type)
+        {
+            case atomicx::TraceType::contextSwitch:
+            {
+                size_t nFrom = GetTid(event.nFrom);
+                size_t nTo   = GetTid(event.nTo);
+
+                if (m_running.count(nFrom))
+                {
+                    snprintf(args, sizeof(args), "\"left\":\"%s\"", GetStatus(event.status));
+                    Slice("run", nFrom, m_running[nFrom], ts, args);
+                    m_running.erase(nFrom);
+                }
+
+                m_running[nTo] = ts;
+                break;
+            }
+
+            case atomicx::TraceType::notify:
+                snprintf(args, sizeof(args), "\"to\":\"%s\",\"message\":%llu", GetName(event.nTo).c_str(), (unsigned long long)event.nValue);
+                Instant("notify", GetTid(event.nFrom), ts, args);
+
+                snprintf(args, sizeof(args), "\"by\":\"%s\",\"was\":\"%s\"", GetName(event.nFrom).c_str(), GetStatus(event.status));
+                Instant("woken", GetTid(event.nTo), ts, args);
+                break;
+
+            case atomicx::TraceType::wait:
+                snprintf(args, sizeof(args), "\"status\":\"%s\",\"endpoint\":\"0x%llx\"", GetStatus(event.status),
+                         (unsigned long long)event.nValue);
+                Instant("wait", GetTid(event.nFrom), ts, args);
+                break;
+
+            case atomicx::TraceType::sleepBegin:
+                m_idleStart = ts;
+                break;
+
+            case atomicx::TraceType::sleepEnd:
+                if (m_idleStart >= 0)
+                {
+                    snprintf(args, sizeof(args), "\"next\":\"%s\"", event.nTo ? GetName(event.nTo).c_str() : "");
+                    Slice("idle", 0, m_idleStart, ts, args);
+                    m_idleStart = -1;
+                }
+                break;
+        }
+    }
+
+    void Begin()
+    {
+        printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        Emit("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"kernel\"}}");
+    }
+
+    void End()
+    {
+        printf("\n]}\n");
+    }
+};
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <dump> [tick in us, default 1000]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *pFile = fopen(argv[1], "rb");
+
+    if (pFile == nullptr)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    atomicx::TraceFileHeader header;
+
+    if (fread(&header, sizeof(header), 1, pFile) != 1 || header.nMagic != ATOMICX_TRACE_MAGIC || header.nVersion != ATOMICX_TRACE_VERSION)
+    {
+        fprintf(stderr, "%s: not an AtomicX event trace\n", argv[1]);
+        fclose(pFile);
+        return 1;
+    }
+
+    Converter converter(argc > 2 ? atof(argv[2]) : 1000.0);
+
+    std::vector<atomicx::TraceFileThread> threads(header.nThreads);
+
+    if (header.nThreads && fread(threads.data(), sizeof(atomicx::TraceFileThread), header.nThreads, pFile) != header.nThreads)
+    {
+        fprintf(stderr, "%s: truncated thread table\n", argv[1]);
+        fclose(pFile);
+        return 1;
+    }
+
+    for (auto &thread : threads)
+    {
+        converter.AddThread(thread);
+    }
+
+    converter.Begin();
+
+    atomicx::TraceFileEvent event;
+    uint32_t nEvents = 0;
+
+    while (nEvents < header.nEvents && fread(&event, sizeof(event), 1, pFile) == 1)
+    {
+        converter.AddEvent(event);
+        nEvents++;
+    }
+
+    converter.End();
+
+    fclose(pFile);
+
+    fprintf(stderr, "%u events, %llu lost to the ring wrap\n", nEvents, (unsigned long long)header.nLost);
+
+    return nEvents == header.nEvents ? 0 : 1;
+}